@@ -0,0 +1,111 @@
+
+#pragma once
+
+#include "vector.h"
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <type_traits>
+#ifdef _MSC_VER
+#include <malloc.h>
+#endif
+
+// Stateless allocator returning memory aligned to Alignment bytes (a cache line
+// by default). The size of every allocation is rounded up to a multiple of
+// Alignment, so full-width vector loads over the last elements of data() never
+// touch memory outside the allocation.
+template<
+	typename T,
+	std::size_t Alignment = 64
+>
+class aligned_allocator
+{
+	static_assert(Alignment && !(Alignment & (Alignment - 1)), "alignment must be a power of two");
+	static_assert(Alignment >= std::alignment_of<T>::value, "alignment must not be weaker than the one of T");
+
+public:
+	typedef T value_type;
+	typedef std::true_type propagate_on_container_move_assignment;
+	typedef std::true_type is_always_equal;
+
+	template<typename U>
+	struct rebind { typedef aligned_allocator<U, Alignment> other; };
+
+	static const std::size_t alignment = Alignment;
+
+	aligned_allocator() FCV_NOEXCEPT
+	{
+	}
+
+	template<typename U>
+	aligned_allocator(const aligned_allocator<U, Alignment>&) FCV_NOEXCEPT
+	{
+	}
+
+	value_type* allocate(std::size_t n)
+	{
+		if(n > (static_cast<std::size_t>(-1) - Alignment) / sizeof(value_type))
+			throw std::bad_alloc();
+
+		const std::size_t bytes = _round_up(n * sizeof(value_type), Alignment);
+		void* p = nullptr;
+#ifdef _MSC_VER
+		p = _aligned_malloc(bytes, Alignment);
+#else
+		// posix_memalign requires at least the alignment of a pointer
+		if(posix_memalign(&p, Alignment < sizeof(void*) ? sizeof(void*) : Alignment, bytes))
+			p = nullptr;
+#endif
+		if(!p)
+			throw std::bad_alloc();
+		return static_cast<value_type*>(p);
+	}
+
+	void deallocate(value_type* p, std::size_t) FCV_NOEXCEPT
+	{
+#ifdef _MSC_VER
+		_aligned_free(p);
+#else
+		std::free(p);
+#endif
+	}
+
+	// smallest capacity >= n that fills whole SIMD registers of laneBytes bytes,
+	// e.g. padded_capacity(13, 32) is 16 for 4 byte elements
+	static std::size_t padded_capacity(std::size_t n, std::size_t laneBytes = Alignment) FCV_NOEXCEPT
+	{
+		if(laneBytes % sizeof(value_type))
+			return n;
+		const std::size_t lanes = laneBytes / sizeof(value_type);
+		return _round_up(n, lanes);
+	}
+
+private:
+	static std::size_t _round_up(std::size_t n, std::size_t multiple) FCV_NOEXCEPT
+	{
+		return (n + multiple - 1) / multiple * multiple;
+	}
+};
+
+template<typename T, std::size_t Alignment>
+const std::size_t aligned_allocator<T, Alignment>::alignment;
+
+
+template<typename T, typename U, std::size_t Alignment>
+bool operator==(const aligned_allocator<T, Alignment>&, const aligned_allocator<U, Alignment>&)
+{
+	return true;
+}
+template<typename T, typename U, std::size_t Alignment>
+bool operator!=(const aligned_allocator<T, Alignment>&, const aligned_allocator<U, Alignment>&)
+{
+	return false;
+}
+
+
+// fixed_capacity_vector whose data() is aligned to Alignment bytes
+template<
+	typename T,
+	std::size_t Alignment = 64
+>
+using aligned_fixed_capacity_vector = fixed_capacity_vector<T, aligned_allocator<T, Alignment>>;
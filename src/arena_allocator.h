@@ -0,0 +1,250 @@
+
+#pragma once
+
+#include "vector.h"
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+
+// Monotonic bump-pointer arena. Memory is carved from a caller supplied buffer
+// and/or from blocks requested from the global operator new. Deallocation is a
+// no-op except for the most recent allocation, which is rolled back; everything
+// else is given back at once by reset(). Blocks obtained from upstream are kept
+// across reset() so a warmed up arena does not allocate at all, release() hands
+// them back. An arena is not thread-safe.
+class arena
+{
+public:
+	// arena that gets all of its memory from upstream in blocks of at least blockSize bytes
+	explicit arena(std::size_t blockSize = 64 * 1024)
+		: cur_(nullptr), end_(nullptr), initial_(nullptr), initialSize_(0)
+		, head_(nullptr), current_(nullptr), blockSize_(blockSize), upstream_(true), used_(0)
+	{
+	}
+
+	// arena over an existing buffer; once it is exhausted allocations either fall
+	// back to upstream blocks of blockSize bytes or throw std::bad_alloc
+	arena(void* buffer, std::size_t size, bool upstreamFallback = false, std::size_t blockSize = 64 * 1024)
+		: cur_(static_cast<char*>(buffer)), end_(static_cast<char*>(buffer) + size)
+		, initial_(static_cast<char*>(buffer)), initialSize_(size)
+		, head_(nullptr), current_(nullptr), blockSize_(blockSize), upstream_(upstreamFallback), used_(0)
+	{
+	}
+
+	arena(const arena&) = delete;
+	arena& operator=(const arena&) = delete;
+
+	~arena() FCV_NOEXCEPT
+	{
+		release();
+	}
+
+	void* allocate(std::size_t bytes, std::size_t alignment)
+	{
+		assert(alignment && !(alignment & (alignment - 1)) && "alignment must be a power of two");
+		char* p = _align(cur_, alignment);
+		if(!p || p > end_ || static_cast<std::size_t>(end_ - p) < bytes)
+		{
+			_next_block(bytes, alignment);
+			p = _align(cur_, alignment);
+		}
+		cur_ = p + bytes;
+		used_ += bytes;
+		return p;
+	}
+
+	void deallocate(void* p, std::size_t bytes) FCV_NOEXCEPT
+	{
+		// only the most recent allocation can be given back
+		if(static_cast<char*>(p) + bytes == cur_)
+		{
+			cur_ = static_cast<char*>(p);
+			used_ -= bytes;
+		}
+	}
+
+	// makes all memory available again; previously handed out memory must not be used anymore
+	void reset() FCV_NOEXCEPT
+	{
+		used_ = 0;
+		if(initial_)
+		{
+			current_ = nullptr;
+			cur_ = initial_;
+			end_ = initial_ + initialSize_;
+		}
+		else
+		{
+			current_ = head_;
+			cur_ = head_ ? _data(head_) : nullptr;
+			end_ = head_ ? _data(head_) + head_->size : nullptr;
+		}
+	}
+
+	// resets the arena and returns all upstream blocks
+	void release() FCV_NOEXCEPT
+	{
+		while(head_)
+		{
+			block* next = head_->next;
+			::operator delete(head_);
+			head_ = next;
+		}
+		reset();
+	}
+
+	// number of bytes handed out since the last reset
+	std::size_t bytes_used() const FCV_NOEXCEPT
+	{
+		return used_;
+	}
+
+	// number of blocks currently held from upstream
+	std::size_t block_count() const FCV_NOEXCEPT
+	{
+		std::size_t count = 0;
+		for(block* b = head_; b; b = b->next)
+			++count;
+		return count;
+	}
+
+private:
+	struct block
+	{
+		block* next;
+		std::size_t size;
+	};
+
+	static char* _data(block* b) FCV_NOEXCEPT
+	{
+		return reinterpret_cast<char*>(b) + _header_size();
+	}
+
+	static std::size_t _header_size() FCV_NOEXCEPT
+	{
+		// keep the data of every block maximally aligned
+		const std::size_t align = std::alignment_of<std::max_align_t>::value;
+		return (sizeof(block) + align - 1) & ~(align - 1);
+	}
+
+	static char* _align(char* p, std::size_t alignment) FCV_NOEXCEPT
+	{
+		if(!p)
+			return nullptr;
+		const std::uintptr_t address = reinterpret_cast<std::uintptr_t>(p);
+		return p + (((address + alignment - 1) & ~(alignment - 1)) - address);
+	}
+
+	void _next_block(std::size_t bytes, std::size_t alignment)
+	{
+		const std::size_t required = bytes + alignment;
+		if(required < bytes)
+			throw std::bad_alloc();
+
+		// reuse a block retained from before the last reset if it is large enough
+		block* next = current_ ? current_->next : head_;
+		if(next && next->size >= required)
+		{
+			_use(next);
+			return;
+		}
+
+		if(!upstream_)
+			throw std::bad_alloc();
+
+		const std::size_t size = required > blockSize_ ? required : blockSize_;
+		block* b = static_cast<block*>(::operator new(_header_size() + size));
+		b->size = size;
+
+		// link the new block right behind the one in use, retained blocks follow it
+		block** link = current_ ? &current_->next : &head_;
+		b->next = *link;
+		*link = b;
+		_use(b);
+	}
+
+	void _use(block* b) FCV_NOEXCEPT
+	{
+		current_ = b;
+		cur_ = _data(b);
+		end_ = cur_ + b->size;
+	}
+
+private:
+	char* cur_;
+	char* end_;
+	char* initial_;	// caller supplied buffer, used before any upstream block
+	std::size_t initialSize_;
+	block* head_;		// upstream blocks in the order they are used
+	block* current_;	// block cur_ points into, nullptr while in the initial buffer
+	std::size_t blockSize_;
+	bool upstream_;
+	std::size_t used_;
+};
+
+
+// Allocator handing out memory from an arena. Copies refer to the same arena and
+// compare equal exactly if they do. The allocator follows its memory on move
+// assignment and swap so containers can exchange buffers in O(1); a copy
+// assigned container keeps allocating from its own arena.
+template<
+	typename T
+>
+class arena_allocator
+{
+public:
+	typedef T value_type;
+	typedef std::false_type propagate_on_container_copy_assignment;
+	typedef std::true_type propagate_on_container_move_assignment;
+	typedef std::true_type propagate_on_container_swap;
+
+	template<typename U>
+	struct rebind { typedef arena_allocator<U> other; };
+
+	arena_allocator(arena& resource) FCV_NOEXCEPT
+		: arena_(&resource)
+	{
+	}
+
+	template<typename U>
+	arena_allocator(const arena_allocator<U>& other) FCV_NOEXCEPT
+		: arena_(other.arena_)
+	{
+	}
+
+	value_type* allocate(std::size_t n)
+	{
+		if(n > static_cast<std::size_t>(-1) / sizeof(value_type))
+			throw std::bad_alloc();
+		return static_cast<value_type*>(arena_->allocate(n * sizeof(value_type), std::alignment_of<value_type>::value));
+	}
+
+	void deallocate(value_type* p, std::size_t n) FCV_NOEXCEPT
+	{
+		arena_->deallocate(p, n * sizeof(value_type));
+	}
+
+	arena& resource() const FCV_NOEXCEPT
+	{
+		return *arena_;
+	}
+
+private:
+	template<typename U>
+	friend class arena_allocator;
+
+	arena* arena_;
+};
+
+
+template<typename T, typename U>
+bool operator==(const arena_allocator<T>& lhs, const arena_allocator<U>& rhs)
+{
+	return &lhs.resource() == &rhs.resource();
+}
+template<typename T, typename U>
+bool operator!=(const arena_allocator<T>& lhs, const arena_allocator<U>& rhs)
+{
+	return !operator==(lhs, rhs);
+}
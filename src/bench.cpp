@@ -0,0 +1,588 @@
+
+#include "vector.h"
+#include "simd_algorithms.h"
+#include "ring_buffer.h"
+#include "soa_vector.h"
+#include "huge_page_allocator.h"
+#include "parallel_algorithms.h"
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+template<typename T>
+typename std::enable_if<!std::is_pointer<T>::value, T>::type make_value(int id) { return T(id); }
+template<typename T>
+typename std::enable_if<std::is_pointer<T>::value, T>::type make_value(int id) { return reinterpret_cast<T>(static_cast<std::intptr_t>(id)); }
+template<>
+std::string make_value<std::string>(int id) { return std::string(32, static_cast<char>('a' + id % 26)); }
+template<>
+std::pair<short, short> make_value<std::pair<short, short>>(int id) { return std::make_pair(id, id); }
+template<>
+std::vector<char> make_value<std::vector<char>>(int id) { return std::vector<char>(32, static_cast<char>(id)); }
+
+// constructs the element from its constructor arguments where the type has some
+template<typename V>
+void emplace_value(V& v) { v.emplace_back(make_value<typename V::value_type>(1)); }
+template<typename V>
+void emplace_value(V& v, std::string*) { v.emplace_back(32, 'x'); }
+template<typename V>
+void emplace_value(V& v, std::vector<char>*) { v.emplace_back(32, 'x'); }
+template<typename V>
+void emplace_value(V& v, std::pair<short, short>*) { v.emplace_back(short(1), short(2)); }
+template<typename V>
+void emplace_value(V& v, void*) { emplace_value(v); }
+
+// a cheap per element value for the iteration benchmark
+inline std::size_t element_value(int value) { return static_cast<std::size_t>(value); }
+inline std::size_t element_value(const void* value) { return reinterpret_cast<std::uintptr_t>(value); }
+inline std::size_t element_value(const std::string& value) { return value.size(); }
+inline std::size_t element_value(const std::pair<short, short>& value) { return static_cast<std::size_t>(value.first); }
+inline std::size_t element_value(const std::vector<char>& value) { return value.size(); }
+
+// creates an empty container that can hold capacity elements without reallocating
+template<typename V>
+struct container_factory;
+
+template<typename T>
+struct container_factory<fixed_capacity_vector<T>>
+{
+	static fixed_capacity_vector<T> make(std::size_t capacity)
+	{
+		return fixed_capacity_vector<T>(static_cast<unsigned int>(capacity));
+	}
+};
+
+template<typename T>
+struct container_factory<std::vector<T>>
+{
+	static std::vector<T> make(std::size_t capacity)
+	{
+		std::vector<T> v;
+		v.reserve(capacity);
+		return v;
+	}
+};
+
+template<typename V>
+V make_filled(std::size_t capacity, std::size_t size)
+{
+	V v = container_factory<V>::make(capacity);
+	v.resize(size, make_value<typename V::value_type>(1));
+	return v;
+}
+
+
+template<typename V>
+void BM_push_back(benchmark::State& state)
+{
+	const auto n = static_cast<std::size_t>(state.range(0));
+	V v = container_factory<V>::make(n);
+	const auto value = make_value<typename V::value_type>(1);
+	for(auto _ : state)
+	{
+		v.clear();
+		for(std::size_t i = 0; i < n; ++i)
+			v.push_back(value);
+		benchmark::DoNotOptimize(v.data());
+	}
+	state.SetItemsProcessed(state.iterations() * n);
+}
+
+template<typename V>
+void BM_emplace_back(benchmark::State& state)
+{
+	const auto n = static_cast<std::size_t>(state.range(0));
+	V v = container_factory<V>::make(n);
+	for(auto _ : state)
+	{
+		v.clear();
+		for(std::size_t i = 0; i < n; ++i)
+			emplace_value(v, static_cast<typename V::value_type*>(nullptr));
+		benchmark::DoNotOptimize(v.data());
+	}
+	state.SetItemsProcessed(state.iterations() * n);
+}
+
+// second argument selects the position: 0 = front, 1 = middle, 2 = back
+template<typename V>
+void BM_insert_erase(benchmark::State& state)
+{
+	const auto n = static_cast<std::size_t>(state.range(0));
+	const auto index = state.range(1) == 0 ? 0 : (state.range(1) == 1 ? n / 2 : n);
+	V v = make_filled<V>(n + 1, n);
+	const auto value = make_value<typename V::value_type>(2);
+	for(auto _ : state)
+	{
+		v.insert(v.begin() + index, value);
+		v.erase(v.begin() + index);
+		benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+
+template<typename V>
+void BM_copy(benchmark::State& state)
+{
+	const auto n = static_cast<std::size_t>(state.range(0));
+	const V v = make_filled<V>(n, n);
+	for(auto _ : state)
+	{
+		V copy(v);
+		benchmark::DoNotOptimize(copy.data());
+	}
+	state.SetItemsProcessed(state.iterations() * n);
+}
+
+template<typename V>
+void BM_move(benchmark::State& state)
+{
+	const auto n = static_cast<std::size_t>(state.range(0));
+	V v = make_filled<V>(n, n);
+	for(auto _ : state)
+	{
+		V moved(std::move(v));
+		v = std::move(moved);
+		benchmark::DoNotOptimize(v.data());
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+
+template<typename V>
+void BM_swap(benchmark::State& state)
+{
+	const auto n = static_cast<std::size_t>(state.range(0));
+	V v = make_filled<V>(n, n);
+	V w = make_filled<V>(n, n / 2);
+	for(auto _ : state)
+	{
+		v.swap(w);
+		benchmark::DoNotOptimize(v.data());
+		benchmark::DoNotOptimize(w.data());
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+
+template<typename V>
+void BM_resize(benchmark::State& state)
+{
+	const auto n = static_cast<std::size_t>(state.range(0));
+	V v = container_factory<V>::make(n);
+	for(auto _ : state)
+	{
+		v.resize(n);
+		benchmark::DoNotOptimize(v.data());
+		v.resize(0);
+	}
+	state.SetItemsProcessed(state.iterations() * n);
+}
+
+template<typename V>
+void BM_iterate(benchmark::State& state)
+{
+	const auto n = static_cast<std::size_t>(state.range(0));
+	const V v = make_filled<V>(n, n);
+	for(auto _ : state)
+	{
+		std::size_t sum = 0;
+		for(const auto& element : v)
+			sum += element_value(element);
+		benchmark::DoNotOptimize(sum);
+	}
+	state.SetItemsProcessed(state.iterations() * n);
+}
+
+template<typename V>
+void register_suite(const std::string& name)
+{
+	const int minSize = 16, maxSize = 1 << 16;
+	benchmark::RegisterBenchmark((name + "/push_back").c_str(), &BM_push_back<V>)->RangeMultiplier(16)->Range(minSize, maxSize);
+	benchmark::RegisterBenchmark((name + "/emplace_back").c_str(), &BM_emplace_back<V>)->RangeMultiplier(16)->Range(minSize, maxSize);
+	benchmark::RegisterBenchmark((name + "/insert_erase").c_str(), &BM_insert_erase<V>)
+		->ArgNames({ "n", "pos" })->ArgsProduct({ benchmark::CreateRange(minSize, maxSize, 16), { 0, 1, 2 } });
+	benchmark::RegisterBenchmark((name + "/copy").c_str(), &BM_copy<V>)->RangeMultiplier(16)->Range(minSize, maxSize);
+	benchmark::RegisterBenchmark((name + "/move").c_str(), &BM_move<V>)->RangeMultiplier(16)->Range(minSize, maxSize);
+	benchmark::RegisterBenchmark((name + "/swap").c_str(), &BM_swap<V>)->RangeMultiplier(16)->Range(minSize, maxSize);
+	benchmark::RegisterBenchmark((name + "/resize").c_str(), &BM_resize<V>)->RangeMultiplier(16)->Range(minSize, maxSize);
+	benchmark::RegisterBenchmark((name + "/iterate").c_str(), &BM_iterate<V>)->RangeMultiplier(16)->Range(minSize, maxSize);
+}
+
+// runs the suite for fixed_capacity_vector and for std::vector with reserve() as baseline
+template<typename T>
+void register_suites(const std::string& type)
+{
+	register_suite<fixed_capacity_vector<T>>("fixed_capacity_vector<" + type + ">");
+	register_suite<std::vector<T>>("std::vector<" + type + ">");
+}
+
+
+// single element insert and erase as they were implemented before the tail
+// shift: append the element and rotate it into position, rotate it to the end and pop
+template<typename V>
+void rotate_insert(V& v, std::size_t index, const typename V::value_type& value)
+{
+	v.push_back(value);
+	std::rotate(v.rbegin(), v.rbegin() + 1, typename V::reverse_iterator(v.begin() + index));
+}
+
+template<typename V>
+void rotate_erase(V& v, std::size_t index)
+{
+	auto p = v.begin() + index;
+	std::rotate(p, p + 1, v.end());
+	v.pop_back();
+}
+
+template<typename T>
+void BM_insert_erase_middle_rotate(benchmark::State& state)
+{
+	const auto n = static_cast<unsigned int>(state.range(0));
+	fixed_capacity_vector<T> v(n + 1);
+	v.resize(n, make_value<T>(1));
+	const auto value = make_value<T>(2);
+	for(auto _ : state)
+	{
+		rotate_insert(v, n / 2, value);
+		rotate_erase(v, n / 2);
+		benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+
+template<typename T>
+void BM_insert_erase_middle_shift(benchmark::State& state)
+{
+	const auto n = static_cast<unsigned int>(state.range(0));
+	fixed_capacity_vector<T> v(n + 1);
+	v.resize(n, make_value<T>(1));
+	const auto value = make_value<T>(2);
+	for(auto _ : state)
+	{
+		v.insert(v.begin() + n / 2, value);
+		v.erase(v.begin() + n / 2);
+		benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_TEMPLATE(BM_insert_erase_middle_rotate, int)->RangeMultiplier(8)->Range(16, 1 << 20);
+BENCHMARK_TEMPLATE(BM_insert_erase_middle_shift, int)->RangeMultiplier(8)->Range(16, 1 << 20);
+BENCHMARK_TEMPLATE(BM_insert_erase_middle_rotate, std::string)->RangeMultiplier(8)->Range(16, 1 << 20);
+BENCHMARK_TEMPLATE(BM_insert_erase_middle_shift, std::string)->RangeMultiplier(8)->Range(16, 1 << 20);
+BENCHMARK_TEMPLATE(BM_insert_erase_middle_rotate, std::vector<char>)->RangeMultiplier(8)->Range(16, 1 << 20);
+BENCHMARK_TEMPLATE(BM_insert_erase_middle_shift, std::vector<char>)->RangeMultiplier(8)->Range(16, 1 << 20);
+
+
+// linear search, count and fill with the std algorithms over begin()/end() and with the
+// SIMD kernels; the searched value is not in the container, so all elements are scanned
+template<typename T>
+void BM_find_std(benchmark::State& state)
+{
+	const auto v = make_filled<fixed_capacity_vector<T>>(state.range(0), state.range(0));
+	const auto value = make_value<T>(2);
+	for(auto _ : state)
+		benchmark::DoNotOptimize(std::find(v.begin(), v.end(), value));
+	state.SetBytesProcessed(state.iterations() * v.size() * sizeof(T));
+}
+
+template<typename T>
+void BM_find_simd(benchmark::State& state)
+{
+	const auto v = make_filled<fixed_capacity_vector<T>>(state.range(0), state.range(0));
+	const auto value = make_value<T>(2);
+	for(auto _ : state)
+		benchmark::DoNotOptimize(fcv_simd::find(v, value));
+	state.SetBytesProcessed(state.iterations() * v.size() * sizeof(T));
+}
+
+template<typename T>
+void BM_count_std(benchmark::State& state)
+{
+	const auto v = make_filled<fixed_capacity_vector<T>>(state.range(0), state.range(0));
+	const auto value = make_value<T>(1);
+	for(auto _ : state)
+		benchmark::DoNotOptimize(std::count(v.begin(), v.end(), value));
+	state.SetBytesProcessed(state.iterations() * v.size() * sizeof(T));
+}
+
+template<typename T>
+void BM_count_simd(benchmark::State& state)
+{
+	const auto v = make_filled<fixed_capacity_vector<T>>(state.range(0), state.range(0));
+	const auto value = make_value<T>(1);
+	for(auto _ : state)
+		benchmark::DoNotOptimize(fcv_simd::count(v, value));
+	state.SetBytesProcessed(state.iterations() * v.size() * sizeof(T));
+}
+
+template<typename T>
+void BM_fill_std(benchmark::State& state)
+{
+	auto v = make_filled<fixed_capacity_vector<T>>(state.range(0), state.range(0));
+	const auto value = make_value<T>(2);
+	for(auto _ : state)
+	{
+		std::fill(v.begin(), v.end(), value);
+		benchmark::ClobberMemory();
+	}
+	state.SetBytesProcessed(state.iterations() * v.size() * sizeof(T));
+}
+
+template<typename T>
+void BM_fill_simd(benchmark::State& state)
+{
+	auto v = make_filled<fixed_capacity_vector<T>>(state.range(0), state.range(0));
+	const auto value = make_value<T>(2);
+	for(auto _ : state)
+	{
+		fcv_simd::fill(v, value);
+		benchmark::ClobberMemory();
+	}
+	state.SetBytesProcessed(state.iterations() * v.size() * sizeof(T));
+}
+
+BENCHMARK_TEMPLATE(BM_find_std, int)->RangeMultiplier(16)->Range(16, 1 << 20);
+BENCHMARK_TEMPLATE(BM_find_simd, int)->RangeMultiplier(16)->Range(16, 1 << 20);
+BENCHMARK_TEMPLATE(BM_find_std, void*)->RangeMultiplier(16)->Range(16, 1 << 20);
+BENCHMARK_TEMPLATE(BM_find_simd, void*)->RangeMultiplier(16)->Range(16, 1 << 20);
+BENCHMARK_TEMPLATE(BM_count_std, int)->RangeMultiplier(16)->Range(16, 1 << 20);
+BENCHMARK_TEMPLATE(BM_count_simd, int)->RangeMultiplier(16)->Range(16, 1 << 20);
+BENCHMARK_TEMPLATE(BM_fill_std, int)->RangeMultiplier(16)->Range(16, 1 << 20);
+BENCHMARK_TEMPLATE(BM_fill_simd, int)->RangeMultiplier(16)->Range(16, 1 << 20);
+
+
+// bounded FIFO queue holding n elements: pop the oldest, push a new one
+template<typename T>
+void BM_queue_vector(benchmark::State& state)
+{
+	const auto n = static_cast<unsigned int>(state.range(0));
+	fixed_capacity_vector<T> v(n);
+	v.resize(n, make_value<T>(1));
+	const auto value = make_value<T>(2);
+	for(auto _ : state)
+	{
+		v.erase(v.begin());
+		v.push_back(value);
+		benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+
+template<typename T>
+void BM_queue_ring(benchmark::State& state)
+{
+	const auto n = static_cast<unsigned int>(state.range(0));
+	fixed_capacity_ring_buffer<T> ring(n);
+	for(unsigned int i = 0; i < n; ++i)
+		ring.push_back(make_value<T>(1));
+	const auto value = make_value<T>(2);
+	for(auto _ : state)
+	{
+		ring.pop_front();
+		ring.push_back(value);
+		benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_TEMPLATE(BM_queue_vector, int)->RangeMultiplier(16)->Range(16, 1 << 16);
+BENCHMARK_TEMPLATE(BM_queue_ring, int)->RangeMultiplier(16)->Range(16, 1 << 16);
+BENCHMARK_TEMPLATE(BM_queue_vector, std::string)->RangeMultiplier(16)->Range(16, 1 << 16);
+BENCHMARK_TEMPLATE(BM_queue_ring, std::string)->RangeMultiplier(16)->Range(16, 1 << 16);
+
+
+// pass over one field of std::pair<short, short> records stored as array of
+// structs versus one column of a struct of arrays, and over both fields zipped
+void BM_scan_field_aos(benchmark::State& state)
+{
+	const auto n = static_cast<unsigned int>(state.range(0));
+	fixed_capacity_vector<std::pair<short, short>> v(n);
+	for(unsigned int i = 0; i < n; ++i)
+		v.push_back(make_value<std::pair<short, short>>(static_cast<int>(i)));
+	for(auto _ : state)
+	{
+		int sum = 0;
+		for(const auto& element : v)
+			sum += element.first;
+		benchmark::DoNotOptimize(sum);
+	}
+	state.SetItemsProcessed(state.iterations() * n);
+}
+
+void BM_scan_field_soa(benchmark::State& state)
+{
+	const auto n = static_cast<unsigned int>(state.range(0));
+	fixed_capacity_soa_vector<short, short> v(n);
+	for(unsigned int i = 0; i < n; ++i)
+		v.emplace_back(static_cast<short>(i), static_cast<short>(i));
+	for(auto _ : state)
+	{
+		int sum = 0;
+		for(short first : v.column<0>())
+			sum += first;
+		benchmark::DoNotOptimize(sum);
+	}
+	state.SetItemsProcessed(state.iterations() * n);
+}
+
+void BM_scan_record_aos(benchmark::State& state)
+{
+	const auto n = static_cast<unsigned int>(state.range(0));
+	fixed_capacity_vector<std::pair<short, short>> v(n);
+	for(unsigned int i = 0; i < n; ++i)
+		v.push_back(make_value<std::pair<short, short>>(static_cast<int>(i)));
+	for(auto _ : state)
+	{
+		int sum = 0;
+		for(const auto& element : v)
+			sum += element.first * element.second;
+		benchmark::DoNotOptimize(sum);
+	}
+	state.SetItemsProcessed(state.iterations() * n);
+}
+
+void BM_scan_record_soa_zip(benchmark::State& state)
+{
+	const auto n = static_cast<unsigned int>(state.range(0));
+	fixed_capacity_soa_vector<short, short> v(n);
+	for(unsigned int i = 0; i < n; ++i)
+		v.emplace_back(static_cast<short>(i), static_cast<short>(i));
+	for(auto _ : state)
+	{
+		int sum = 0;
+		for(auto row : v)
+			sum += std::get<0>(row) * std::get<1>(row);
+		benchmark::DoNotOptimize(sum);
+	}
+	state.SetItemsProcessed(state.iterations() * n);
+}
+
+BENCHMARK(BM_scan_field_aos)->RangeMultiplier(16)->Range(16, 1 << 24);
+BENCHMARK(BM_scan_field_soa)->RangeMultiplier(16)->Range(16, 1 << 24);
+BENCHMARK(BM_scan_record_aos)->RangeMultiplier(16)->Range(16, 1 << 24);
+BENCHMARK(BM_scan_record_soa_zip)->RangeMultiplier(16)->Range(16, 1 << 24);
+
+
+// chases indices through a single random cycle over all elements (Sattolo's
+// algorithm), so every load depends on the previous one and mostly misses the TLB
+// once the buffer covers far more than the TLB reach of 4 KB pages
+template<page_backing Preferred>
+void BM_random_access(benchmark::State& state)
+{
+	const auto n = static_cast<std::size_t>(state.range(0));
+	fixed_capacity_vector<std::uint32_t, huge_page_allocator<std::uint32_t>, std::size_t> v(n, huge_page_allocator<std::uint32_t>(Preferred));
+	v.resize(n);
+	std::iota(v.begin(), v.end(), 0u);
+	std::mt19937 random;
+	for(std::size_t i = n - 1; i > 0; --i)
+		std::swap(v[i], v[std::uniform_int_distribution<std::size_t>(0, i - 1)(random)]);
+
+	const char* names[] = { "small pages", "transparent huge pages advised", "explicit huge pages" };
+	state.SetLabel(names[static_cast<int>(v.get_allocator().backing())]);
+
+	std::uint32_t index = 0;
+	for(auto _ : state)
+	{
+		for(int i = 0; i < 1024; ++i)
+			index = v[index];
+		benchmark::DoNotOptimize(index);
+	}
+	state.SetItemsProcessed(state.iterations() * 1024);
+}
+
+BENCHMARK_TEMPLATE(BM_random_access, page_backing::small_pages)->RangeMultiplier(16)->Range(1 << 16, 1 << 26);
+BENCHMARK_TEMPLATE(BM_random_access, page_backing::transparent_huge_pages_advised)->RangeMultiplier(16)->Range(1 << 16, 1 << 26);
+BENCHMARK_TEMPLATE(BM_random_access, page_backing::explicit_huge_pages)->RangeMultiplier(16)->Range(1 << 16, 1 << 26);
+
+
+template<typename T>
+void BM_copy_construct_serial(benchmark::State& state)
+{
+	const auto n = static_cast<unsigned int>(state.range(0));
+	fixed_capacity_vector<T> v(n);
+	for(unsigned int i = 0; i < n; ++i)
+		v.push_back(make_value<T>(static_cast<int>(i)));
+	for(auto _ : state)
+	{
+		fixed_capacity_vector<T> copy(v);
+		benchmark::DoNotOptimize(copy.data());
+	}
+	state.SetItemsProcessed(state.iterations() * n);
+}
+
+template<typename T>
+void BM_copy_construct_parallel(benchmark::State& state)
+{
+	const auto n = static_cast<unsigned int>(state.range(0));
+	fixed_capacity_vector<T> v(n);
+	for(unsigned int i = 0; i < n; ++i)
+		v.push_back(make_value<T>(static_cast<int>(i)));
+	for(auto _ : state)
+	{
+		fixed_capacity_vector<T> copy = fcv_parallel::copy_of(v);
+		benchmark::DoNotOptimize(copy.data());
+	}
+	state.SetItemsProcessed(state.iterations() * n);
+}
+
+void BM_sort_serial(benchmark::State& state)
+{
+	const auto n = static_cast<unsigned int>(state.range(0));
+	fixed_capacity_vector<std::uint32_t> v(n);
+	std::mt19937 random;
+	for(auto _ : state)
+	{
+		state.PauseTiming();
+		v.clear();
+		for(unsigned int i = 0; i < n; ++i)
+			v.push_back(random());
+		state.ResumeTiming();
+		std::sort(v.begin(), v.end());
+	}
+	state.SetItemsProcessed(state.iterations() * n);
+}
+
+void BM_sort_parallel(benchmark::State& state)
+{
+	const auto n = static_cast<unsigned int>(state.range(0));
+	fixed_capacity_vector<std::uint32_t> v(n);
+	std::mt19937 random;
+	for(auto _ : state)
+	{
+		state.PauseTiming();
+		v.clear();
+		for(unsigned int i = 0; i < n; ++i)
+			v.push_back(random());
+		state.ResumeTiming();
+		fcv_parallel::sort(v.begin(), v.end());
+	}
+	state.SetItemsProcessed(state.iterations() * n);
+}
+
+BENCHMARK_TEMPLATE(BM_copy_construct_serial, int)->RangeMultiplier(16)->Range(1 << 12, 1 << 24);
+BENCHMARK_TEMPLATE(BM_copy_construct_parallel, int)->RangeMultiplier(16)->Range(1 << 12, 1 << 24);
+BENCHMARK_TEMPLATE(BM_copy_construct_serial, std::string)->RangeMultiplier(16)->Range(1 << 12, 1 << 20);
+BENCHMARK_TEMPLATE(BM_copy_construct_parallel, std::string)->RangeMultiplier(16)->Range(1 << 12, 1 << 20);
+BENCHMARK(BM_sort_serial)->RangeMultiplier(16)->Range(1 << 12, 1 << 24);
+BENCHMARK(BM_sort_parallel)->RangeMultiplier(16)->Range(1 << 12, 1 << 24);
+
+
+int main(int argc, char* argv[])
+{
+	// same element types as TypesUnderTest in main.cpp
+	register_suites<int>("int");
+	register_suites<void*>("void*");
+	register_suites<const void*>("const void*");
+	register_suites<std::string>("std::string");
+	register_suites<std::pair<short, short>>("std::pair<short, short>");
+	register_suites<std::vector<char>>("std::vector<char>");
+
+	benchmark::Initialize(&argc, argv);
+	if(benchmark::ReportUnrecognizedArguments(argc, argv))
+		return 1;
+	benchmark::RunSpecifiedBenchmarks();
+	benchmark::Shutdown();
+	return 0;
+}
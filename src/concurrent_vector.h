@@ -0,0 +1,215 @@
+
+#pragma once
+
+#include "vector.h"
+#include <atomic>
+#include <stdexcept>
+
+// Fixed capacity vector that any number of threads may append to concurrently
+// without a lock. A slot is reserved with one atomic fetch-add on the reservation
+// counter, so producers never wait for each other while they construct their
+// elements. Readers only see the published prefix: a per slot flag marks finished
+// elements and the publication counter is advanced over the prefix of flagged
+// slots by whichever producer completes the gap, so size() never includes an
+// element that is still under construction. Appending is lock-free, not wait-free:
+// a producer may have to retry the counter update while others advance it.
+//
+// Elements are constructed in a noexcept context because a reserved slot cannot
+// be given back; a throwing constructor terminates the program. Construction,
+// destruction and clear() must not overlap with any other member call.
+template<
+	typename _Ty,
+	typename _Alloc = std::allocator<_Ty>
+>
+class concurrent_append_vector
+{
+public:
+	typedef _Ty value_type;
+	typedef _Alloc allocator_type;
+	typedef unsigned int size_type;
+	typedef const value_type* const_iterator;
+
+	explicit concurrent_append_vector(size_type _capacity, const allocator_type& allocator = allocator_type())
+		: buffer_(nullptr), ready_(nullptr), capacity_(_capacity), allocator_(allocator)
+		, reserved_(0), published_(0)
+	{
+		if(capacity_)
+		{
+			ready_.reset(new std::atomic<bool>[capacity_]());
+			buffer_ = std::allocator_traits<allocator_type>::allocate(allocator_, capacity_);
+		}
+	}
+
+	concurrent_append_vector(const concurrent_append_vector&) = delete;
+	concurrent_append_vector& operator=(const concurrent_append_vector&) = delete;
+
+	~concurrent_append_vector() FCV_NOEXCEPT
+	{
+		clear();
+		if(buffer_)
+			std::allocator_traits<allocator_type>::deallocate(allocator_, buffer_, capacity_);
+	}
+
+	// constructs an element in a freshly reserved slot and returns its index; the
+	// element is visible to readers once all slots before it are finished as well
+	template<
+		typename... _TyArgs
+	>
+	size_type emplace_back(_TyArgs&&... args)
+	{
+		size_type index;
+		if(!_reserve(index))
+			throw std::length_error("concurrent_append_vector out of capacity");
+		_construct(index, std::forward<_TyArgs>(args)...);
+		_publish(index);
+		return index;
+	}
+
+	size_type push_back(const value_type& value)
+	{
+		return emplace_back(value);
+	}
+
+	size_type push_back(value_type&& value)
+	{
+		return emplace_back(std::move(value));
+	}
+
+	// like emplace_back() but returns false instead of throwing when the vector is full
+	template<
+		typename... _TyArgs
+	>
+	bool try_emplace_back(_TyArgs&&... args)
+	{
+		size_type index;
+		if(!_reserve(index))
+			return false;
+		_construct(index, std::forward<_TyArgs>(args)...);
+		_publish(index);
+		return true;
+	}
+
+	// number of published elements; all elements below it are fully constructed
+	size_type size() const FCV_NOEXCEPT
+	{
+		return published_.load(std::memory_order_acquire);
+	}
+
+	size_type capacity() const FCV_NOEXCEPT
+	{
+		return capacity_;
+	}
+
+	bool empty() const FCV_NOEXCEPT
+	{
+		return size() == 0;
+	}
+
+	// true once every slot has been reserved, even if not all of them are published yet
+	bool full() const FCV_NOEXCEPT
+	{
+		return reserved_.load(std::memory_order_relaxed) >= capacity_;
+	}
+
+	const value_type& operator[](size_type index) const
+	{
+		assert(index < size());
+		return buffer_[index];
+	}
+
+	const value_type* data() const FCV_NOEXCEPT
+	{
+		return buffer_;
+	}
+
+	// iterates over the elements published at the time of the call
+	const_iterator begin() const FCV_NOEXCEPT
+	{
+		return buffer_;
+	}
+
+	const_iterator end() const FCV_NOEXCEPT
+	{
+		return buffer_ + size();
+	}
+
+	allocator_type get_allocator() const
+	{
+		return allocator_;
+	}
+
+	// destroys all elements, must not run concurrently with producers or readers
+	void clear() FCV_NOEXCEPT
+	{
+		const size_type count = published_.load(std::memory_order_acquire);
+		assert(count == _reserved() && "clear() called while elements are still being constructed");
+		for(size_type i = 0; i < count; ++i)
+		{
+			std::allocator_traits<allocator_type>::destroy(allocator_, buffer_ + i);
+			ready_[i].store(false, std::memory_order_relaxed);
+		}
+		reserved_.store(0, std::memory_order_relaxed);
+		published_.store(0, std::memory_order_release);
+	}
+
+private:
+	size_type _reserved() const FCV_NOEXCEPT
+	{
+		const size_type reserved = reserved_.load(std::memory_order_relaxed);
+		return reserved < capacity_ ? reserved : capacity_;
+	}
+
+	bool _reserve(size_type& index) FCV_NOEXCEPT
+	{
+		// checking first keeps the counter from running away once the vector is full,
+		// it can overshoot the capacity by at most the number of concurrent producers
+		if(reserved_.load(std::memory_order_relaxed) >= capacity_)
+			return false;
+		index = reserved_.fetch_add(1, std::memory_order_relaxed);
+		return index < capacity_;
+	}
+
+	template<
+		typename... _TyArgs
+	>
+	void _construct(size_type index, _TyArgs&&... args) FCV_NOEXCEPT
+	{
+		std::allocator_traits<allocator_type>::construct(allocator_, buffer_ + index, std::forward<_TyArgs>(args)...);
+	}
+
+	void _publish(size_type index) FCV_NOEXCEPT
+	{
+		ready_[index].store(true, std::memory_order_release);
+		// A producer that stops the counter in front of this slot has moved the counter,
+		// then found the flag unset. Without a full fence both sides could miss the
+		// other's store and leave the slot unpublished. With the fences, either this
+		// producer sees the moved counter or the other one sees the flag.
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+
+		// advance the publication counter over all finished slots; if another producer
+		// moves it first, the loop continues from there or stops at an unfinished slot
+		size_type published = published_.load(std::memory_order_acquire);
+		while(published < capacity_ && ready_[published].load(std::memory_order_acquire))
+		{
+			if(published_.compare_exchange_weak(published, published + 1,
+				std::memory_order_acq_rel, std::memory_order_acquire))
+			{
+				++published;
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+			}
+		}
+	}
+
+private:
+	value_type* buffer_;
+	std::unique_ptr<std::atomic<bool>[]> ready_;
+	size_type capacity_;
+	allocator_type allocator_;
+	// the counters are written by every producer, keep them on separate cache lines
+	// from each other and from the read-mostly members above
+	char pad0_[64];
+	std::atomic<size_type> reserved_;
+	char pad1_[64 - sizeof(std::atomic<size_type>)];
+	std::atomic<size_type> published_;
+	char pad2_[64 - sizeof(std::atomic<size_type>)];
+};
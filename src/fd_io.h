@@ -0,0 +1,164 @@
+
+#pragma once
+
+#include "posix_io.h"
+#include "vector.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <initializer_list>
+#include <type_traits>
+#include <vector>
+#include <sys/uio.h>
+#include <unistd.h>
+
+// Byte vectors as zero-copy I/O buffers: read_from() reads from a file descriptor
+// straight into the unused capacity behind size() and grows the vector by the
+// bytes received, write_to() sends the elements behind a cursor and advances it.
+// A protocol parser can consume the front of the vector in place and erase the
+// consumed bytes (a memmove) once it wants the room back. Errors other than
+// interruptions and a non-blocking descriptor that is not ready throw
+// std::system_error.
+namespace fcv_io
+{
+	enum class io_status
+	{
+		ok,
+		end_of_file,	// read_from() only
+		would_block,	// non-blocking descriptor not ready, try again later
+		full			// read_from() had no free capacity left
+	};
+
+	struct io_result
+	{
+		std::size_t bytes;
+		io_status status;
+	};
+
+	namespace detail
+	{
+		template<typename _Vector>
+		struct is_byte_vector : std::integral_constant<bool, sizeof(typename _Vector::value_type) == 1
+			&& std::is_trivially_copyable<typename _Vector::value_type>::value>
+		{
+		};
+
+		// calls op, which returns the result of read/write, until it does not fail with EINTR
+		template<typename _Op>
+		io_result retry(_Op op, const char* what)
+		{
+			const ::ssize_t n = fcv_detail::retry_on_eintr(op);
+			if(n >= 0)
+			{
+				const io_result result = { static_cast<std::size_t>(n), io_status::ok };
+				return result;
+			}
+			if(errno != EAGAIN && errno != EWOULDBLOCK)
+				fcv_detail::throw_errno(what);
+			const io_result result = { 0, io_status::would_block };
+			return result;
+		}
+	}
+
+	// Appends at most capacity() - size() bytes with a single read(). The new bytes
+	// are not initialized beforehand, resize_and_overwrite() hands the free
+	// capacity to read() directly.
+	template<
+		typename _Vector
+	>
+	io_result read_from(int fd, _Vector& v)
+	{
+		static_assert(detail::is_byte_vector<_Vector>::value, "read_from() requires a vector of bytes");
+		typedef typename _Vector::value_type value_type;
+		typedef typename _Vector::size_type size_type;
+
+		io_result result = { 0, io_status::full };
+		const size_type oldSize = v.size();
+		if(oldSize == v.capacity())
+			return result;
+
+		v.resize_and_overwrite(v.capacity(), [&](value_type* data, size_type capacity)
+		{
+			result = detail::retry([&] { return ::read(fd, data + oldSize, capacity - oldSize); }, "read failed");
+			if(result.status == io_status::ok && !result.bytes)
+				result.status = io_status::end_of_file;
+			return oldSize + static_cast<size_type>(result.bytes);
+		});
+		return result;
+	}
+
+	// Like read_from() for several vectors with one readv(): the free capacity of
+	// every vector is filled in order before the next one receives bytes.
+	template<
+		typename _Vector
+	>
+	io_result read_from(int fd, std::initializer_list<_Vector*> vectors)
+	{
+		static_assert(detail::is_byte_vector<_Vector>::value, "read_from() requires vectors of bytes");
+
+		std::vector<typename _Vector::size_type> oldSizes;
+		std::vector<::iovec> iov;
+		oldSizes.reserve(vectors.size());
+		iov.reserve(vectors.size());
+		for(_Vector* v : vectors)
+		{
+			oldSizes.push_back(v->size());
+			if(v->size() < v->capacity())
+				iov.push_back({ v->data() + v->size(), static_cast<std::size_t>(v->capacity() - v->size()) });
+		}
+
+		io_result result = { 0, io_status::full };
+		if(iov.empty())
+			return result;
+
+		std::size_t i = 0;
+		try
+		{
+			// only byte vectors with trivial construction leave the new elements untouched
+			for(_Vector* v : vectors)
+				v->resize_default_init(v->capacity());
+			// readv() reads at most IOV_MAX buffers, the others stay unused for this call
+			result = detail::retry([&] { return ::readv(fd, iov.data(), static_cast<int>(std::min(iov.size(), fcv_detail::iov_max()))); },
+				"readv failed");
+		}
+		catch(...)
+		{
+			for(_Vector* v : vectors)
+				v->resize_default_init(oldSizes[i++]);
+			throw;
+		}
+
+		if(result.status == io_status::ok && !result.bytes)
+			result.status = io_status::end_of_file;
+		std::size_t left = result.bytes;
+		for(_Vector* v : vectors)
+		{
+			const std::size_t got = std::min<std::size_t>(left, v->capacity() - oldSizes[i]);
+			v->resize_default_init(static_cast<typename _Vector::size_type>(oldSizes[i] + got));
+			left -= got;
+			++i;
+		}
+		return result;
+	}
+
+	// Writes the elements from offset up to size() with a single write() and
+	// advances offset by the bytes written. Once offset reaches size(), the vector
+	// can be cleared and the offset reset.
+	template<
+		typename _Vector
+	>
+	io_result write_to(int fd, const _Vector& v, std::size_t& offset)
+	{
+		static_assert(detail::is_byte_vector<_Vector>::value, "write_to() requires a vector of bytes");
+		assert(offset <= v.size() && "write_to() offset beyond the end of the vector");
+
+		if(offset == v.size())
+		{
+			const io_result result = { 0, io_status::ok };
+			return result;
+		}
+		const io_result result = detail::retry([&] { return ::write(fd, v.data() + offset, v.size() - offset); }, "write failed");
+		offset += result.bytes;
+		return result;
+	}
+}
@@ -0,0 +1,202 @@
+
+#pragma once
+
+#include "vector.h"
+#include <cstddef>
+#include <cstdio>
+#include <fstream>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <sys/mman.h>
+#include <unistd.h>
+
+// Pages backing an allocation of huge_page_allocator, ordered from the least to
+// the most TLB friendly.
+enum class page_backing
+{
+	small_pages,					// ordinary pages of the system page size
+	transparent_huge_pages_advised,	// aligned mapping advised with MADV_HUGEPAGE
+	explicit_huge_pages				// MAP_HUGETLB from the reserved huge page pool
+};
+
+namespace fcv_detail
+{
+	// default huge page size of the kernel (Hugepagesize in /proc/meminfo), which
+	// MAP_HUGETLB mappings are a multiple of; 2 MB if it cannot be read
+	inline std::size_t huge_page_size()
+	{
+		static const std::size_t size = []() -> std::size_t
+		{
+			std::ifstream file("/proc/meminfo");
+			std::string line;
+			unsigned long kilobytes = 0;
+			while(std::getline(file, line))
+				if(std::sscanf(line.c_str(), "Hugepagesize: %lu kB", &kilobytes) == 1 && kilobytes)
+					return static_cast<std::size_t>(kilobytes) * 1024;
+			return 2 * 1024 * 1024;
+		}();
+		return size;
+	}
+
+	inline std::size_t small_page_size() FCV_NOEXCEPT
+	{
+		static const long size = ::sysconf(_SC_PAGESIZE);
+		return size > 0 ? static_cast<std::size_t>(size) : 4096;
+	}
+
+	// false if transparent huge pages are switched off system-wide, in which case
+	// MADV_HUGEPAGE succeeds but has no effect
+	inline bool transparent_huge_pages_enabled()
+	{
+		static const bool enabled = []
+		{
+			std::ifstream file("/sys/kernel/mm/transparent_hugepage/enabled");
+			std::string mode;
+			return std::getline(file, mode) && mode.find("[never]") == std::string::npos;
+		}();
+		return enabled;
+	}
+}
+
+// Allocator mapping memory directly with mmap so that large buffers can be backed
+// by huge pages, which cover 2 MB per TLB entry on x86-64 instead of 4 KB and so
+// make random access over hundreds of MB far cheaper. An allocation of at least a
+// huge page first tries explicit huge pages (only available if the administrator
+// reserved some in /proc/sys/vm/nr_hugepages), then a huge page aligned mapping
+// advised with MADV_HUGEPAGE, and finally ordinary pages. The preferred backing
+// passed to the constructor limits how far up this list allocations start.
+// backing() tells which of them the last allocation got; get_allocator() of a
+// container returns it. For transparent huge pages that is only the advice: the
+// kernel decides on every page fault whether a huge page is free, AnonHugePages
+// in /proc/self/smaps shows what the mapping got. Smaller allocations always use
+// ordinary pages, rounded up to the page size.
+template<
+	typename T
+>
+class huge_page_allocator
+{
+public:
+	typedef T value_type;
+	typedef std::true_type propagate_on_container_move_assignment;
+	typedef std::true_type propagate_on_container_swap;
+	typedef std::true_type is_always_equal;
+
+	template<typename U>
+	struct rebind { typedef huge_page_allocator<U> other; };
+
+	explicit huge_page_allocator(page_backing preferred = page_backing::explicit_huge_pages) FCV_NOEXCEPT
+		: preferred_(preferred), backing_(page_backing::small_pages)
+	{
+	}
+
+	template<typename U>
+	huge_page_allocator(const huge_page_allocator<U>& other) FCV_NOEXCEPT
+		: preferred_(other.preferred()), backing_(page_backing::small_pages)
+	{
+	}
+
+	value_type* allocate(std::size_t n)
+	{
+		if(n > (static_cast<std::size_t>(-1) - fcv_detail::huge_page_size()) / sizeof(value_type))
+			throw std::bad_alloc();
+
+		const std::size_t length = _mapping_length(n);
+		page_backing backing = page_backing::small_pages;
+		void* p = nullptr;
+		if(length >= fcv_detail::huge_page_size())
+		{
+#ifdef MAP_HUGETLB
+			if(preferred_ == page_backing::explicit_huge_pages)
+			{
+				p = _map(length, MAP_HUGETLB);
+				if(p)
+					backing = page_backing::explicit_huge_pages;
+			}
+#endif
+#ifdef MADV_HUGEPAGE
+			if(!p && preferred_ != page_backing::small_pages && fcv_detail::transparent_huge_pages_enabled())
+			{
+				p = _map_huge_page_aligned(length);
+				if(p && ::madvise(p, length, MADV_HUGEPAGE) == 0)
+					backing = page_backing::transparent_huge_pages_advised;
+			}
+#endif
+		}
+		if(!p)
+			p = _map(length, 0);
+		if(!p)
+			throw std::bad_alloc();
+
+		backing_ = backing;
+		return static_cast<value_type*>(p);
+	}
+
+	void deallocate(value_type* p, std::size_t n) FCV_NOEXCEPT
+	{
+		// every backing maps the same length, so any allocator can release any allocation
+		::munmap(p, _mapping_length(n));
+	}
+
+	page_backing preferred() const FCV_NOEXCEPT
+	{
+		return preferred_;
+	}
+
+	// backing of the last allocation made through this allocator
+	page_backing backing() const FCV_NOEXCEPT
+	{
+		return backing_;
+	}
+
+private:
+	static std::size_t _round_up(std::size_t n, std::size_t multiple) FCV_NOEXCEPT
+	{
+		return (n + multiple - 1) / multiple * multiple;
+	}
+
+	static std::size_t _mapping_length(std::size_t n) FCV_NOEXCEPT
+	{
+		const std::size_t bytes = n ? n * sizeof(value_type) : 1;
+		return _round_up(bytes, bytes >= fcv_detail::huge_page_size() ? fcv_detail::huge_page_size() : fcv_detail::small_page_size());
+	}
+
+	static void* _map(std::size_t length, int flags) FCV_NOEXCEPT
+	{
+		void* p = ::mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | flags, -1, 0);
+		return p == MAP_FAILED ? nullptr : p;
+	}
+
+	// the kernel only uses huge pages for the huge page aligned part of a mapping,
+	// so a larger mapping is made and trimmed to an aligned one
+	static void* _map_huge_page_aligned(std::size_t length) FCV_NOEXCEPT
+	{
+		char* p = static_cast<char*>(_map(length + fcv_detail::huge_page_size(), 0));
+		if(!p)
+			return nullptr;
+
+		char* aligned = reinterpret_cast<char*>(_round_up(reinterpret_cast<std::size_t>(p), fcv_detail::huge_page_size()));
+		if(aligned != p)
+			::munmap(p, static_cast<std::size_t>(aligned - p));
+		const std::size_t tail = static_cast<std::size_t>(p + fcv_detail::huge_page_size() - aligned);
+		if(tail)
+			::munmap(aligned + length, tail);
+		return aligned;
+	}
+
+private:
+	page_backing preferred_;
+	page_backing backing_;
+};
+
+
+template<typename T, typename U>
+bool operator==(const huge_page_allocator<T>&, const huge_page_allocator<U>&)
+{
+	return true;
+}
+template<typename T, typename U>
+bool operator!=(const huge_page_allocator<T>&, const huge_page_allocator<U>&)
+{
+	return false;
+}
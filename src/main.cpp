@@ -1,7 +1,28 @@
 
 #include "vector.h"
+#include "static_vector.h"
 #include "allocator_mock.h"
+#include "aligned_allocator.h"
+#include "arena_allocator.h"
+#include "pool_allocator.h"
+#include "simd_algorithms.h"
+#include "concurrent_vector.h"
+#include "ring_buffer.h"
+#include "soa_vector.h"
+#include "mapped_vector.h"
+#include "shared_vector.h"
+#include "huge_page_allocator.h"
+#include "numa_allocator.h"
+#include "parallel_algorithms.h"
+#include "serialization.h"
+#include "fd_io.h"
 #include <array>
+#include <deque>
+#include <functional>
+#include <iterator>
+#include <numeric>
+#include <thread>
+#include <sys/wait.h>
 #include <gtest/gtest.h>
 
 template<typename T>
@@ -13,6 +34,221 @@ std::string construct<std::string>(int id) { return std::string(id, '~'); }
 template<>
 std::pair<short, short> construct<std::pair<short, short>>(int id) { return std::make_pair(id, id); }
 
+// wraps an iterator so that algorithms only see a single pass input range
+template<typename It>
+class single_pass_iterator
+{
+public:
+	typedef std::input_iterator_tag iterator_category;
+	typedef typename std::iterator_traits<It>::value_type value_type;
+	typedef typename std::iterator_traits<It>::difference_type difference_type;
+	typedef typename std::iterator_traits<It>::pointer pointer;
+	typedef typename std::iterator_traits<It>::reference reference;
+
+	explicit single_pass_iterator(It it) : it_(it) {}
+	reference operator*() const { return *it_; }
+	single_pass_iterator& operator++() { ++it_; return *this; }
+	single_pass_iterator operator++(int) { single_pass_iterator tmp(*this); ++it_; return tmp; }
+	bool operator==(const single_pass_iterator& other) const { return it_ == other.it_; }
+	bool operator!=(const single_pass_iterator& other) const { return it_ != other.it_; }
+
+private:
+	It it_;
+};
+
+template<typename It>
+single_pass_iterator<It> single_pass(It it) { return single_pass_iterator<It>(it); }
+
+// compares range insert, erase and assign against std::vector
+template<typename V>
+void check_range_operations(const std::function<V()>& make)
+{
+	typedef typename V::value_type value_type;
+	std::vector<value_type> source;
+	for(int i=0; i<5; ++i)
+		source.push_back(construct<value_type>(20 + i));
+
+	for(std::size_t s : { 0, 1, 3, 6 })
+	{
+		for(std::size_t offset = 0; offset <= s; ++offset)
+		{
+			for(std::size_t n : { 0, 1, 2, 5 })
+			{
+				if(s + n > 11)
+					continue;
+				V myvec = make();
+				std::vector<value_type> expected;
+				for(std::size_t i=0; i<s; ++i)
+				{
+					myvec.push_back(construct<value_type>(i));
+					expected.push_back(construct<value_type>(i));
+				}
+
+				// forward iterator range
+				auto ret = myvec.insert(myvec.begin() + offset, source.begin(), source.begin() + n);
+				expected.insert(expected.begin() + offset, source.begin(), source.begin() + n);
+				ASSERT_EQ(offset, ret - myvec.begin());
+				ASSERT_EQ(expected.size(), myvec.size());
+				ASSERT_EQ(true, std::equal(expected.begin(), expected.end(), myvec.begin()));
+
+				// count copies of a value
+				ret = myvec.insert(myvec.begin() + offset, n, construct<value_type>(7));
+				expected.insert(expected.begin() + offset, n, construct<value_type>(7));
+				ASSERT_EQ(offset, ret - myvec.begin());
+				ASSERT_EQ(true, std::equal(expected.begin(), expected.end(), myvec.begin()));
+
+				// erase everything inserted again
+				ret = myvec.erase(myvec.begin() + offset, myvec.begin() + offset + 2 * n);
+				expected.erase(expected.begin() + offset, expected.begin() + offset + 2 * n);
+				ASSERT_EQ(offset, ret - myvec.begin());
+				ASSERT_EQ(expected.size(), myvec.size());
+				ASSERT_EQ(true, std::equal(expected.begin(), expected.end(), myvec.begin()));
+			}
+		}
+	}
+
+	V myvec = make();
+	const auto capacity = myvec.capacity();
+
+	// initializer_list and single pass ranges
+	myvec.insert(myvec.end(), { construct<value_type>(1), construct<value_type>(2) });
+	const value_type more[] = { construct<value_type>(3), construct<value_type>(4), construct<value_type>(5) };
+	myvec.insert(myvec.begin() + 1, single_pass(std::begin(more)), single_pass(std::end(more)));
+	ASSERT_EQ(5, myvec.size());
+	const int expected[] = { 1, 3, 4, 5, 2 };
+	for(std::size_t i=0; i<myvec.size(); ++i)
+		ASSERT_EQ(construct<value_type>(expected[i]), myvec[i]);
+
+	// insert an element of the vector itself
+	myvec.insert(myvec.begin(), 2, myvec[2]);
+	ASSERT_EQ(construct<value_type>(4), myvec[0]);
+	ASSERT_EQ(construct<value_type>(4), myvec[1]);
+	ASSERT_EQ(construct<value_type>(1), myvec[2]);
+	myvec.insert(myvec.begin() + 1, myvec[3]);
+	ASSERT_EQ(construct<value_type>(3), myvec[1]);
+	ASSERT_EQ(construct<value_type>(1), myvec[3]);
+	ASSERT_EQ(construct<value_type>(3), myvec[4]);
+
+	// too many elements leave the vector unchanged
+	const V copy(myvec);
+	ASSERT_THROW(myvec.insert(myvec.begin(), capacity, construct<value_type>(0)), std::length_error);
+	std::vector<value_type> many(capacity + 1, construct<value_type>(9));
+	ASSERT_THROW(myvec.insert(myvec.begin(), single_pass(many.begin()), single_pass(many.end())), std::length_error);
+	ASSERT_EQ(copy.size(), myvec.size());
+	ASSERT_EQ(true, std::equal(copy.begin(), copy.end(), myvec.begin()));
+
+	// assign
+	myvec.assign(source.begin(), source.begin() + 2);
+	ASSERT_EQ(2, myvec.size());
+	ASSERT_EQ(true, std::equal(source.begin(), source.begin() + 2, myvec.begin()));
+	myvec.assign(source.begin(), source.end());
+	ASSERT_EQ(source.size(), myvec.size());
+	ASSERT_EQ(true, std::equal(source.begin(), source.end(), myvec.begin()));
+	myvec.assign(3, myvec[4]);
+	ASSERT_EQ(3, myvec.size());
+	for(std::size_t i=0; i<myvec.size(); ++i)
+		ASSERT_EQ(construct<value_type>(24), myvec[i]);
+	myvec.assign(capacity, construct<value_type>(1));
+	ASSERT_EQ(capacity, myvec.size());
+	myvec.assign({ construct<value_type>(5) });
+	ASSERT_EQ(1, myvec.size());
+	ASSERT_EQ(construct<value_type>(5), myvec[0]);
+	myvec.assign(single_pass(std::begin(more)), single_pass(std::end(more)));
+	ASSERT_EQ(3, myvec.size());
+	ASSERT_EQ(construct<value_type>(4), myvec[1]);
+	ASSERT_THROW(myvec.assign(many.begin(), many.end()), std::length_error);
+	ASSERT_THROW(myvec.assign(capacity + 1, construct<value_type>(0)), std::length_error);
+}
+
+template<typename V>
+void check_unordered_erase(V& myvec)
+{
+	typedef typename V::value_type value_type;
+	auto sorted = [](std::vector<value_type> v) { std::sort(v.begin(), v.end()); return v; };
+
+	for(std::size_t i=0; i<10; ++i)
+		myvec.push_back(construct<value_type>(i));
+
+	// erase front, middle and back
+	std::vector<value_type> expected(myvec.begin(), myvec.end());
+	for(std::size_t index : { 0, 4, 7 })
+	{
+		auto ret = myvec.erase_unordered(myvec.begin() + index);
+		ASSERT_EQ(myvec.begin() + index, ret);
+		expected.erase(std::find(expected.begin(), expected.end(), expected[index]));
+		ASSERT_EQ(sorted(expected), sorted(std::vector<value_type>(myvec.begin(), myvec.end())));
+		std::copy(myvec.begin(), myvec.end(), expected.begin());
+	}
+	myvec.erase_unordered(myvec.end() - 1);
+	ASSERT_EQ(6, myvec.size());
+
+	// erase_if_unordered with nothing, some and all elements matching
+	myvec.clear();
+	for(std::size_t i=0; i<10; ++i)
+		myvec.push_back(construct<value_type>(i));
+	ASSERT_EQ(0, myvec.erase_if_unordered([](const value_type&) { return false; }));
+	ASSERT_EQ(10, myvec.size());
+
+	std::vector<value_type> odd, even;
+	for(std::size_t i=0; i<10; ++i)
+		(i % 2 ? odd : even).push_back(construct<value_type>(i));
+	std::size_t calls = 0;
+	auto is_odd = [&](const value_type& v) {
+		++calls;
+		return std::find(odd.begin(), odd.end(), v) != odd.end();
+	};
+	ASSERT_EQ(5, myvec.erase_if_unordered(is_odd));
+	ASSERT_EQ(10, calls);
+	ASSERT_EQ(sorted(even), sorted(std::vector<value_type>(myvec.begin(), myvec.end())));
+
+	ASSERT_EQ(5, myvec.erase_if_unordered([](const value_type&) { return true; }));
+	ASSERT_EQ(true, myvec.empty());
+	ASSERT_EQ(0, myvec.erase_if_unordered([](const value_type&) { return true; }));
+}
+
+template<typename V>
+void check_default_init_resize(V& myvec)
+{
+	typedef typename V::value_type value_type;
+	const auto c = myvec.capacity();
+
+	myvec.resize(3, construct<value_type>(5));
+	myvec.resize_default_init(6);
+	ASSERT_EQ(6, myvec.size());
+	for(std::size_t i=0; i<3; ++i)
+		ASSERT_EQ(construct<value_type>(5), myvec[i]);
+	myvec.resize_default_init(2);
+	ASSERT_EQ(2, myvec.size());
+	ASSERT_THROW(myvec.resize_default_init(c + 1), std::length_error);
+	ASSERT_EQ(2, myvec.size());
+
+	// fill the tail and keep only part of it
+	myvec.resize_and_overwrite(c, [](value_type* p, typename V::size_type n) {
+		for(typename V::size_type i=2; i<n; ++i)
+			p[i] = construct<value_type>(i);
+		return n - 1;
+	});
+	ASSERT_EQ(c - 1, myvec.size());
+	ASSERT_EQ(construct<value_type>(5), myvec[1]);
+	for(std::size_t i=2; i<myvec.size(); ++i)
+		ASSERT_EQ(construct<value_type>(i), myvec[i]);
+
+	// shrinking hands out the remaining elements only
+	myvec.resize_and_overwrite(3, [](value_type* p, typename V::size_type n) {
+		p[0] = construct<value_type>(9);
+		return n;
+	});
+	ASSERT_EQ(3, myvec.size());
+	ASSERT_EQ(construct<value_type>(9), myvec[0]);
+	ASSERT_EQ(construct<value_type>(2), myvec[2]);
+
+	// a throwing operation keeps the elements that existed before
+	ASSERT_THROW(myvec.resize_and_overwrite(c, [](value_type*, typename V::size_type) -> typename V::size_type {
+		throw std::runtime_error("failed");
+	}), std::runtime_error);
+	ASSERT_EQ(3, myvec.size());
+}
+
 
 template<typename T>
 class fcv_basic_test : public ::testing::Test
@@ -93,7 +329,7 @@ TYPED_TEST(fcv_basic_test, resize)
 		else if(oldSize > newSize)
 		{
 			expectedStats.DestroyCalls += 
-				std::is_scalar<typename TypeParam::value_type>::value ? 0 : (oldSize - newSize);
+				std::is_trivially_destructible<typename TypeParam::value_type>::value ? 0 : (oldSize - newSize);
 		}
 		ASSERT_EQ(expectedStats, stats);
 
@@ -212,7 +448,7 @@ TYPED_TEST(fcv_basic_test, dtor)
 		size = myvec.size();
 	}
 	expectedStats.DestroyCalls += 
-		std::is_scalar<typename TypeParam::value_type>::value ? 0 : size;
+		std::is_trivially_destructible<typename TypeParam::value_type>::value ? 0 : size;
 	++expectedStats.DeallocateCalls;
 	ASSERT_EQ(expectedStats, stats);
 }
@@ -232,7 +468,7 @@ TYPED_TEST(fcv_basic_test, clear)
 	auto size = myvec.size();
 	myvec.clear();
 	expectedStats.DestroyCalls +=
-		std::is_scalar<typename TypeParam::value_type>::value ? 0 : size;
+		std::is_trivially_destructible<typename TypeParam::value_type>::value ? 0 : size;
 	ASSERT_EQ(expectedStats, stats);
 }
 
@@ -268,7 +504,7 @@ TYPED_TEST(fcv_basic_test, copy_constructor)
 			ASSERT_EQ(expectedStats, stats);
 		}
 
-		expectedStats.DestroyCalls = std::is_scalar<typename TypeParam::value_type>::value 
+		expectedStats.DestroyCalls = std::is_trivially_destructible<typename TypeParam::value_type>::value 
 			? 0 : expectedStats.ConstructCalls;
 		expectedStats.DeallocateCalls = c ? 2 : 0;
 		ASSERT_EQ(expectedStats, stats);
@@ -310,7 +546,7 @@ TYPED_TEST(fcv_basic_test, move_constructor)
 			ASSERT_EQ(expectedStats, stats);
 		}
 
-		expectedStats.DestroyCalls = std::is_scalar<typename TypeParam::value_type>::value 
+		expectedStats.DestroyCalls = std::is_trivially_destructible<typename TypeParam::value_type>::value 
 			? 0 : expectedStats.ConstructCalls;
 		expectedStats.DeallocateCalls = c ? 1 : 0;
 		ASSERT_EQ(expectedStats, stats);
@@ -349,7 +585,7 @@ TYPED_TEST(fcv_basic_test, initlist_constructor)
 
 			// track destructor calls
 			expectedStats.DestroyCalls += 
-				std::is_scalar<typename TypeParam::value_type>::value ? 0 : myvec.size();
+				std::is_trivially_destructible<typename TypeParam::value_type>::value ? 0 : myvec.size();
 			expectedStats.DeallocateCalls += (c ? 1 : 0);
 		}
 		else
@@ -396,7 +632,7 @@ TYPED_TEST(fcv_basic_test, copy_assign)
 
 		// track stats for destruction of myvec2
 		expectedStats.DestroyCalls += 
-			std::is_scalar<typename TypeParam::value_type>::value ? 0 : myvec2.size();
+			std::is_trivially_destructible<typename TypeParam::value_type>::value ? 0 : myvec2.size();
 		++expectedStats.DeallocateCalls;
 	}
 
@@ -418,12 +654,12 @@ TYPED_TEST(fcv_basic_test, copy_assign)
 		for(std::size_t i=0; i<myvec.size(); ++i)
 			ASSERT_EQ(data[i], data2[i]);
 		// check allocator calls (no allocation, deallocation, we just destroy what is too much)
-		expectedStats.DestroyCalls += std::is_scalar<typename TypeParam::value_type>::value 
+		expectedStats.DestroyCalls += std::is_trivially_destructible<typename TypeParam::value_type>::value 
 			? 0 : (oldSize - myvec2.size());
 		ASSERT_EQ(expectedStats, stats);
 		
 		// track stats for destruction of myvec2
-		expectedStats.DestroyCalls += std::is_scalar<typename TypeParam::value_type>::value 
+		expectedStats.DestroyCalls += std::is_trivially_destructible<typename TypeParam::value_type>::value 
 			? 0 : myvec2.size();
 		++expectedStats.DeallocateCalls;
 	}
@@ -447,7 +683,7 @@ TYPED_TEST(fcv_basic_test, copy_assign)
 			ASSERT_EQ(data[i], data2[i]);
 		// check allocator calls
 		expectedStats.DestroyCalls += 
-			std::is_scalar<typename TypeParam::value_type>::value ? 0 : oldSize;
+			std::is_trivially_destructible<typename TypeParam::value_type>::value ? 0 : oldSize;
 		++expectedStats.DeallocateCalls;
 		++expectedStats.AllocateCalls;
 		expectedStats.ConstructCalls += myvec2.size();
@@ -482,7 +718,7 @@ TYPED_TEST(fcv_basic_test, move_assign)
 		auto oldSize = myvec.size();
 		myvec = std::move(myvec2);
 		expectedStats.DestroyCalls += 
-			std::is_scalar<typename TypeParam::value_type>::value ? 0 : oldSize;
+			std::is_trivially_destructible<typename TypeParam::value_type>::value ? 0 : oldSize;
 		expectedStats.DeallocateCalls += (oldCapacity ? 1 : 0);
 		ASSERT_EQ(expectedStats, stats);
 	}
@@ -536,7 +772,7 @@ TYPED_TEST(fcv_basic_test, initlist_assign)
 				if(oldSize > il.size())
 				{
 					expectedStats.DestroyCalls += 
-						std::is_scalar<typename TypeParam::value_type>::value ? 0 : (oldSize - il.size());
+						std::is_trivially_destructible<typename TypeParam::value_type>::value ? 0 : (oldSize - il.size());
 				}
 				if(oldSize < il.size())
 					expectedStats.ConstructCalls += (il.size() - oldSize);
@@ -650,7 +886,7 @@ TYPED_TEST(fcv_basic_test, pop_back)
 		const auto data = myvec.data();
 		ASSERT_EQ(true, std::equal(data, data + expectedSize, begin(expected)));
 		// check allocator calls
-		if(!std::is_scalar<typename TypeParam::value_type>::value)
+		if(!std::is_trivially_destructible<typename TypeParam::value_type>::value)
 			++expectedStats.DestroyCalls;
 		ASSERT_EQ(expectedStats, stats);
 	}
@@ -772,7 +1008,7 @@ TYPED_TEST(fcv_basic_test, swap)
 	
 		// track destruction 
 		expectedStats.DestroyCalls +=
-			std::is_scalar<typename TypeParam::value_type>::value ? 0 : myvec2.size();
+			std::is_trivially_destructible<typename TypeParam::value_type>::value ? 0 : myvec2.size();
 		expectedStats.DeallocateCalls += (myvec2.capacity() ? 1 : 0);
 	}
 }
@@ -983,13 +1219,2088 @@ TYPED_TEST(fcv_basic_test, erase)
 				
 				// check allocator mock
 				expectedStats.DestroyCalls += 
-					std::is_scalar<typename TypeParam::value_type>::value ? 0 : 1;
+					std::is_trivially_destructible<typename TypeParam::value_type>::value ? 0 : 1;
 				ASSERT_EQ(expectedStats, stats);			
 			}		
 		}	
 	}
 }
 
+TYPED_TEST(fcv_basic_test, emplace)
+{
+	typedef AllocatorMock<typename TypeParam::value_type> alloc_t;
+	typedef typename alloc_t::Statistics stats_t;
+
+	stats_t stats, expectedStats(1, 0, 0, 0);
+	const std::size_t c = 8;
+	TypeParam myvec(c, alloc_t(&stats));
+
+	// emplace_back constructs exactly once, directly in the buffer
+	for(std::size_t i=0; i<4; ++i)
+	{
+		auto& ref = myvec.emplace_back(construct<typename TypeParam::value_type>(i));
+		++expectedStats.ConstructCalls;
+		ASSERT_EQ(expectedStats, stats);
+		ASSERT_EQ(&myvec.back(), &ref);
+		ASSERT_EQ(construct<typename TypeParam::value_type>(i), ref);
+	}
+
+	// emplace in front, middle and back
+	auto ret = myvec.emplace(myvec.begin(), construct<typename TypeParam::value_type>(10));
+	ASSERT_EQ(myvec.begin(), ret);
+	ret = myvec.emplace(myvec.begin() + 2, construct<typename TypeParam::value_type>(11));
+	ASSERT_EQ(myvec.begin() + 2, ret);
+	ret = myvec.emplace(myvec.end(), construct<typename TypeParam::value_type>(12));
+	ASSERT_EQ(myvec.end() - 1, ret);
+	expectedStats.ConstructCalls += 3;
+	ASSERT_EQ(expectedStats, stats);
+
+	const int expected[] = { 10, 0, 11, 1, 2, 3, 12 };
+	ASSERT_EQ(7, myvec.size());
+	for(std::size_t i=0; i<myvec.size(); ++i)
+		ASSERT_EQ(construct<typename TypeParam::value_type>(expected[i]), myvec[i]);
+
+	// emplace from an element of the vector itself
+	myvec.emplace(myvec.begin(), myvec.back());
+	ASSERT_EQ(construct<typename TypeParam::value_type>(12), myvec.front());
+
+	// full vector
+	ASSERT_THROW(myvec.emplace_back(construct<typename TypeParam::value_type>(13)), std::length_error);
+	ASSERT_THROW(myvec.emplace(myvec.begin(), construct<typename TypeParam::value_type>(13)), std::length_error);
+	ASSERT_EQ(c, myvec.size());
+}
+
+TEST(fcv_emplace_test, constructor_arguments)
+{
+	fixed_capacity_vector<std::string> strings(4);
+	ASSERT_EQ("xxx", strings.emplace_back(3, 'x'));
+	strings.emplace(strings.begin(), 2, 'y');
+	ASSERT_EQ("yy", strings[0]);
+	ASSERT_EQ("xxx", strings[1]);
+
+	fixed_capacity_vector<std::pair<short, short>> pairs(4);
+	pairs.emplace_back(short(1), short(2));
+	ASSERT_EQ(std::make_pair(short(1), short(2)), pairs.back());
+
+	static_vector<std::vector<char>, 4> vectors;
+	ASSERT_EQ(5, vectors.emplace_back(5, 'z').size());
+	vectors.emplace(vectors.begin(), 1, 'a');
+	ASSERT_EQ(std::vector<char>(1, 'a'), vectors.front());
+}
+
+TYPED_TEST(fcv_basic_test, range_operations)
+{
+	check_range_operations<TypeParam>([]() { return TypeParam(16); });
+
+	typedef AllocatorMock<typename TypeParam::value_type> alloc_t;
+	typedef typename alloc_t::Statistics stats_t;
+
+	// every inserted element is constructed exactly once, every erased one destroyed once
+	for(std::size_t offset : { 0, 2, 6 })
+	{
+		stats_t stats, expectedStats(1, 0, 0, 0);
+		TypeParam myvec(16, alloc_t(&stats));
+		myvec.resize(6);
+		expectedStats.ConstructCalls += 6;
+
+		std::vector<typename TypeParam::value_type> values(4, construct<typename TypeParam::value_type>(3));
+		myvec.insert(myvec.begin() + offset, values.begin(), values.end());
+		expectedStats.ConstructCalls += 4;
+		ASSERT_EQ(expectedStats, stats);
+
+		myvec.erase(myvec.begin() + offset, myvec.begin() + offset + 4);
+		expectedStats.DestroyCalls +=
+			std::is_trivially_destructible<typename TypeParam::value_type>::value ? 0 : 4;
+		ASSERT_EQ(expectedStats, stats);
+	}
+}
+
+TYPED_TEST(fcv_basic_test, erase_unordered)
+{
+	typedef AllocatorMock<typename TypeParam::value_type> alloc_t;
+	typedef typename alloc_t::Statistics stats_t;
+
+	TypeParam myvec(16);
+	check_unordered_erase(myvec);
+
+	// erasing destroys exactly one element and constructs nothing
+	stats_t stats, expectedStats(1, 0, 0, 0);
+	TypeParam myvec2(8, alloc_t(&stats));
+	myvec2.resize(8);
+	expectedStats.ConstructCalls += 8;
+	myvec2.erase_unordered(myvec2.begin() + 2);
+	expectedStats.DestroyCalls +=
+		std::is_trivially_destructible<typename TypeParam::value_type>::value ? 0 : 1;
+	ASSERT_EQ(expectedStats, stats);
+}
+
+TYPED_TEST(fcv_basic_test, resize_default_init)
+{
+	typedef AllocatorMock<typename TypeParam::value_type> alloc_t;
+	typedef typename alloc_t::Statistics stats_t;
+
+	TypeParam myvec(8);
+	check_default_init_resize(myvec);
+
+	// AllocatorMock observes construction, so every element still goes through it
+	stats_t stats, expectedStats(1, 0, 0, 0);
+	TypeParam myvec2(8, alloc_t(&stats));
+	myvec2.resize_default_init(5);
+	expectedStats.ConstructCalls += 5;
+	ASSERT_EQ(expectedStats, stats);
+}
+
+template<typename T>
+class sv_basic_test : public ::testing::Test
+{
+public:
+};
+
+typedef ::testing::Types<
+	static_vector<int, 8>,
+	static_vector<void*, 8>,
+	static_vector<const void*, 8>,
+	static_vector<std::string, 8>,
+	static_vector<std::pair<short, short>, 8>,
+	static_vector<std::vector<char>, 8>
+> StaticTypesUnderTest;
+TYPED_TEST_CASE(sv_basic_test, StaticTypesUnderTest);
+
+
+TYPED_TEST(sv_basic_test, inline_storage)
+{
+	const TypeParam myvec;
+	ASSERT_EQ(8, myvec.capacity());
+	ASSERT_EQ(0, myvec.size());
+	ASSERT_EQ(true, myvec.empty());
+
+	// the buffer is part of the object itself
+	auto self = reinterpret_cast<const char*>(&myvec);
+	auto data = reinterpret_cast<const char*>(myvec.data());
+	ASSERT_EQ(true, data >= self && data + 8 * sizeof(typename TypeParam::value_type) <= self + sizeof(myvec));
+}
+
+TYPED_TEST(sv_basic_test, push_back_and_pop_back)
+{
+	const std::size_t c = 8;
+	TypeParam myvec;
+	std::array<typename TypeParam::value_type, c> expected;
+
+	for(std::size_t i=0; i<c; ++i)
+	{
+		expected[i] = construct<typename TypeParam::value_type>(i);
+		if(i % 2)
+			ASSERT_NO_THROW(myvec.push_back(expected[i]));
+		else
+			ASSERT_NO_THROW(myvec.push_back(construct<typename TypeParam::value_type>(i)));
+		ASSERT_EQ(i+1, myvec.size());
+		ASSERT_EQ(true, std::equal(myvec.begin(), myvec.end(), begin(expected)));
+	}
+
+	// cases where vector is full
+	ASSERT_THROW(myvec.push_back(construct<typename TypeParam::value_type>(c)), std::length_error);
+	ASSERT_EQ(c, myvec.size());
+	ASSERT_EQ(true, std::equal(myvec.begin(), myvec.end(), begin(expected)));
+
+	for(std::size_t i=0; i<c; ++i)
+	{
+		myvec.pop_back();
+		ASSERT_EQ(c-i-1, myvec.size());
+		ASSERT_EQ(true, std::equal(myvec.begin(), myvec.end(), begin(expected)));
+	}
+}
+
+TYPED_TEST(sv_basic_test, resize)
+{
+	const std::size_t c = 8;
+	TypeParam myvec;
+	std::array<typename TypeParam::value_type, c> expected;
+
+	for(auto s : { 3, 7, 1, 8, 0, 4 })
+	{
+		auto oldSize = myvec.size();
+		std::copy(myvec.begin(), myvec.end(), begin(expected));
+
+		ASSERT_NO_THROW(myvec.resize(s, construct<typename TypeParam::value_type>(s)));
+		ASSERT_EQ(s, myvec.size());
+		ASSERT_EQ(true, std::equal(myvec.begin(), myvec.begin() + std::min<std::size_t>(oldSize, s), begin(expected)));
+		for(std::size_t i=oldSize; i<myvec.size(); ++i)
+			ASSERT_EQ(construct<typename TypeParam::value_type>(s), myvec[i]);
+	}
+
+	auto oldSize = myvec.size();
+	ASSERT_THROW(myvec.resize(c + 1), std::length_error);
+	ASSERT_EQ(oldSize, myvec.size());
+}
+
+TYPED_TEST(sv_basic_test, copy_and_move)
+{
+	TypeParam myvec { construct<typename TypeParam::value_type>(0),
+		construct<typename TypeParam::value_type>(1), construct<typename TypeParam::value_type>(2) };
+	ASSERT_EQ(3, myvec.size());
+
+	// copy constructor
+	TypeParam myvec2(myvec);
+	ASSERT_EQ(3, myvec2.size());
+	ASSERT_EQ(true, std::equal(myvec.begin(), myvec.end(), myvec2.begin()));
+
+	// copy assignment (larger = smaller and smaller = larger)
+	TypeParam myvec3;
+	myvec3.resize(6);
+	myvec3 = myvec;
+	ASSERT_EQ(true, std::equal(myvec.begin(), myvec.end(), myvec3.begin()));
+	ASSERT_EQ(3, myvec3.size());
+	myvec3.pop_back();
+	myvec3 = myvec;
+	ASSERT_EQ(3, myvec3.size());
+	ASSERT_EQ(true, std::equal(myvec.begin(), myvec.end(), myvec3.begin()));
+
+	// move constructor empties the source
+	TypeParam myvec4(std::move(myvec2));
+	ASSERT_EQ(0, myvec2.size());
+	ASSERT_EQ(true, std::equal(myvec.begin(), myvec.end(), myvec4.begin()));
+
+	// move assignment
+	TypeParam myvec5;
+	myvec5.resize(1);
+	myvec5 = std::move(myvec4);
+	ASSERT_EQ(0, myvec4.size());
+	ASSERT_EQ(3, myvec5.size());
+	ASSERT_EQ(true, std::equal(myvec.begin(), myvec.end(), myvec5.begin()));
+
+	// initializer_list assignment
+	myvec5 = { construct<typename TypeParam::value_type>(7) };
+	ASSERT_EQ(1, myvec5.size());
+	ASSERT_EQ(construct<typename TypeParam::value_type>(7), myvec5.front());
+
+	ASSERT_THROW((TypeParam { construct<typename TypeParam::value_type>(0), construct<typename TypeParam::value_type>(1),
+		construct<typename TypeParam::value_type>(2), construct<typename TypeParam::value_type>(3),
+		construct<typename TypeParam::value_type>(4), construct<typename TypeParam::value_type>(5),
+		construct<typename TypeParam::value_type>(6), construct<typename TypeParam::value_type>(7),
+		construct<typename TypeParam::value_type>(8) }), std::length_error);
+}
+
+TYPED_TEST(sv_basic_test, swap)
+{
+	for(std::size_t s1 : { 0, 3, 8 })
+	{
+		for(std::size_t s2 : { 0, 5, 8 })
+		{
+			TypeParam myvec, myvec2;
+			for(std::size_t i=0; i<s1; ++i)
+				myvec.push_back(construct<typename TypeParam::value_type>(i));
+			for(std::size_t i=0; i<s2; ++i)
+				myvec2.push_back(construct<typename TypeParam::value_type>(10 + i));
+
+			swap(myvec, myvec2);
+			ASSERT_EQ(s2, myvec.size());
+			ASSERT_EQ(s1, myvec2.size());
+			for(std::size_t i=0; i<s2; ++i)
+				ASSERT_EQ(construct<typename TypeParam::value_type>(10 + i), myvec[i]);
+			for(std::size_t i=0; i<s1; ++i)
+				ASSERT_EQ(construct<typename TypeParam::value_type>(i), myvec2[i]);
+		}
+	}
+}
+
+TYPED_TEST(sv_basic_test, insert_and_erase)
+{
+	const std::size_t s = 6;
+	std::array<typename TypeParam::value_type, s> expected;
+	for(std::size_t i=0; i<s; ++i)
+		expected[i] = construct<typename TypeParam::value_type>(i);
+
+	for(std::size_t offset : { 0, 1, 3, 5, 6 })
+	{
+		TypeParam myvec;
+		for(std::size_t i=0; i<s; ++i)
+			myvec.push_back(expected[i]);
+
+		const auto value = construct<typename TypeParam::value_type>(13);
+		auto ret = myvec.insert(myvec.begin() + offset, value);
+		ASSERT_EQ(offset, ret - myvec.begin());
+		ret = myvec.insert(myvec.begin() + offset, construct<typename TypeParam::value_type>(14));
+		ASSERT_EQ(offset, ret - myvec.begin());
+		ASSERT_EQ(s + 2, myvec.size());
+		for(std::size_t i=0; i<offset; ++i)
+			ASSERT_EQ(expected[i], myvec[i]);
+		ASSERT_EQ(construct<typename TypeParam::value_type>(14), myvec[offset]);
+		ASSERT_EQ(value, myvec[offset + 1]);
+		for(std::size_t i=offset + 2; i<myvec.size(); ++i)
+			ASSERT_EQ(expected[i-2], myvec[i]);
+
+		// full vector
+		ASSERT_THROW(myvec.insert(myvec.begin(), value), std::length_error);
+		ASSERT_EQ(s + 2, myvec.size());
+
+		// erase both inserted elements again
+		ret = myvec.erase(myvec.begin() + offset);
+		ASSERT_EQ(offset, ret - myvec.begin());
+		ret = myvec.erase(myvec.begin() + offset);
+		ASSERT_EQ(offset, ret - myvec.begin());
+		ASSERT_EQ(s, myvec.size());
+		ASSERT_EQ(true, std::equal(myvec.begin(), myvec.end(), begin(expected)));
+	}
+}
+
+TYPED_TEST(sv_basic_test, iterators)
+{
+	TypeParam myvec;
+	for(std::size_t i=0; i<4; ++i)
+		myvec.push_back(construct<typename TypeParam::value_type>(i));
+
+	const auto& c_myvec = myvec;
+	ASSERT_EQ(4, myvec.end() - myvec.begin());
+	ASSERT_EQ(4, c_myvec.cend() - c_myvec.cbegin());
+	ASSERT_EQ(4, myvec.rend() - myvec.rbegin());
+	ASSERT_EQ(4, c_myvec.crend() - c_myvec.crbegin());
+	ASSERT_EQ(true, std::equal(myvec.rbegin(), myvec.rend(), c_myvec.crbegin()));
+	ASSERT_EQ(construct<typename TypeParam::value_type>(3), *c_myvec.rbegin());
+	ASSERT_EQ(construct<typename TypeParam::value_type>(0), c_myvec.front());
+	ASSERT_EQ(construct<typename TypeParam::value_type>(3), c_myvec.back());
+}
+
+TYPED_TEST(sv_basic_test, range_operations)
+{
+	typedef static_vector<typename TypeParam::value_type, 16> vector_t;
+	check_range_operations<vector_t>([]() { return vector_t(); });
+}
+
+TYPED_TEST(sv_basic_test, erase_unordered)
+{
+	static_vector<typename TypeParam::value_type, 16> myvec;
+	check_unordered_erase(myvec);
+}
+
+TYPED_TEST(sv_basic_test, resize_default_init)
+{
+	TypeParam myvec;
+	check_default_init_resize(myvec);
+}
+
+template<typename T>
+class fcv_default_alloc_test : public ::testing::Test
+{
+public:
+};
+
+// std::allocator does not observe single constructions, so int, void* and
+// std::pair<short, short> take the bulk copy paths here
+typedef ::testing::Types<
+	fixed_capacity_vector<int>,
+	fixed_capacity_vector<void*>,
+	fixed_capacity_vector<std::string>,
+	fixed_capacity_vector<std::pair<short, short>>,
+	fixed_capacity_vector<std::vector<char>>,
+	fixed_capacity_vector<int, std::allocator<int>, std::uint8_t>,
+	fixed_capacity_vector<std::string, std::allocator<std::string>, std::uint16_t>,
+	fixed_capacity_vector<std::pair<short, short>, std::allocator<std::pair<short, short>>, std::size_t>
+> DefaultAllocTypesUnderTest;
+TYPED_TEST_CASE(fcv_default_alloc_test, DefaultAllocTypesUnderTest);
+
+
+TYPED_TEST(fcv_default_alloc_test, copy)
+{
+	const std::size_t c = 64;
+	TypeParam myvec(c);
+	for(std::size_t i=0; i<c/2; ++i)
+		myvec.push_back(construct<typename TypeParam::value_type>(i + 1));
+
+	// copy constructor
+	TypeParam myvec2(myvec);
+	ASSERT_EQ(myvec.size(), myvec2.size());
+	ASSERT_EQ(true, std::equal(myvec.begin(), myvec.end(), myvec2.begin()));
+
+	// assign larger = smaller, smaller = larger and different capacity
+	for(std::size_t s : { std::size_t(0), std::size_t(3), c/2, c })
+	{
+		for(std::size_t c2 : { c, c + 5 })
+		{
+			TypeParam myvec3(c2);
+			myvec3.resize(s, construct<typename TypeParam::value_type>(99));
+			myvec3 = myvec;
+			ASSERT_EQ(c, myvec3.capacity());
+			ASSERT_EQ(myvec.size(), myvec3.size());
+			ASSERT_EQ(true, std::equal(myvec.begin(), myvec.end(), myvec3.begin()));
+		}
+	}
+}
+
+TYPED_TEST(fcv_default_alloc_test, resize)
+{
+	const std::size_t c = 64;
+	TypeParam myvec(c);
+	for(auto v : { 0, 0, 7, 0 })
+	{
+		const auto value = construct<typename TypeParam::value_type>(v);
+		auto oldSize = myvec.size();
+		myvec.resize(oldSize + 10, value);
+		ASSERT_EQ(oldSize + 10, myvec.size());
+		for(std::size_t i=oldSize; i<myvec.size(); ++i)
+			ASSERT_EQ(value, myvec[i]);
+	}
+	myvec.resize(3);
+	ASSERT_EQ(3, myvec.size());
+	for(std::size_t i=0; i<myvec.size(); ++i)
+		ASSERT_EQ(construct<typename TypeParam::value_type>(0), myvec[i]);
+}
+
+TYPED_TEST(fcv_default_alloc_test, range_operations)
+{
+	check_range_operations<TypeParam>([]() { return TypeParam(16); });
+}
+
+TYPED_TEST(fcv_default_alloc_test, erase_unordered)
+{
+	TypeParam myvec(16);
+	check_unordered_erase(myvec);
+}
+
+TYPED_TEST(fcv_default_alloc_test, resize_default_init)
+{
+	TypeParam myvec(8);
+	check_default_init_resize(myvec);
+}
+
+TEST(fcv_default_init_test, no_zero_fill)
+{
+	// trivial elements are not touched by resize_default_init, so the memory
+	// still holds what was written there before
+	fixed_capacity_vector<int> myvec(1000);
+	myvec.resize(1000, 42);
+	myvec.clear();
+	myvec.resize_default_init(1000);
+	ASSERT_EQ(1000, std::count(myvec.begin(), myvec.end(), 42));
+
+	// typical use: read straight into the tail of the vector
+	const char message[] = "hello world";
+	fixed_capacity_vector<char> buffer(64);
+	buffer.resize_and_overwrite(buffer.capacity(), [&](char* p, unsigned int n) {
+		auto length = std::min<std::size_t>(n, sizeof(message) - 1);
+		std::memcpy(p, message, length);
+		return length;
+	});
+	ASSERT_EQ(std::string(message), std::string(buffer.begin(), buffer.end()));
+}
+
+namespace
+{
+	// copy construction stays trivial, but copy assignment is user-provided and
+	// counted, like the assignment operators of std::pair
+	struct counted_assignment
+	{
+		static int assignments;
+
+		counted_assignment() = default;
+		counted_assignment(const counted_assignment&) = default;
+		counted_assignment& operator=(const counted_assignment& other) { value = other.value; ++assignments; return *this; }
+
+		int value;
+	};
+	int counted_assignment::assignments = 0;
+}
+
+TEST(fcv_bulk_copy_test, trait)
+{
+	static_assert(fcv_detail::is_bulk_copyable<int>::value, "");
+	static_assert(fcv_detail::is_bulk_copyable<std::pair<short, short>>::value, "");
+	static_assert(fcv_detail::is_bulk_copyable<counted_assignment>::value, "");
+	static_assert(!fcv_detail::is_bulk_copyable<std::string>::value, "");
+	static_assert(!fcv_detail::is_bulk_copyable<std::unique_ptr<int>>::value, "");
+}
+
+TEST(fcv_bulk_copy_test, copies_bytes)
+{
+	// the bulk paths copy with memcpy and never call the assignment operator
+	fixed_capacity_vector<counted_assignment> a(8), b(8);
+	static_vector<counted_assignment, 8> c, d;
+	for(int i = 0; i < 4; ++i)
+	{
+		a.push_back(counted_assignment());
+		a.back().value = i;
+		c.push_back(a.back());
+	}
+	b.resize_default_init(2);
+	d.resize_default_init(2);
+	counted_assignment::assignments = 0;
+	b = a;
+	d = c;
+	ASSERT_EQ(0, counted_assignment::assignments);
+	ASSERT_EQ(4, b.size());
+	ASSERT_EQ(3, b[3].value);
+	ASSERT_EQ(4, d.size());
+	ASSERT_EQ(3, d[3].value);
+
+	// an allocator with construct() sees every element, so pairs are constructed one by one
+	typedef AllocatorMock<std::pair<short, short>> alloc_t;
+	alloc_t::Statistics stats;
+	fixed_capacity_vector<std::pair<short, short>, alloc_t> pairs(8, alloc_t(&stats));
+	pairs.resize(5);
+	ASSERT_EQ(5, stats.ConstructCalls);
+	fixed_capacity_vector<std::pair<short, short>, alloc_t> pairsCopy(pairs);
+	ASSERT_EQ(10, stats.ConstructCalls);
+}
+
+TEST(fcv_allocator_test, move_assign_unequal_allocators)
+{
+	// AllocatorMock does not propagate on move assignment, so elements have to be moved
+	typedef AllocatorMock<std::string> alloc_t;
+	typedef alloc_t::Statistics stats_t;
+
+	stats_t stats, stats2;
+	fixed_capacity_vector<std::string, alloc_t> myvec(4, alloc_t(&stats));
+	fixed_capacity_vector<std::string, alloc_t> myvec2(6, alloc_t(&stats2));
+	myvec.push_back("a");
+	myvec2.push_back("b");
+	myvec2.push_back("c");
+
+	myvec = std::move(myvec2);
+	ASSERT_EQ(alloc_t(&stats), myvec.get_allocator());
+	ASSERT_EQ(6, myvec.capacity());
+	ASSERT_EQ(2, myvec.size());
+	ASSERT_EQ("b", myvec[0]);
+	ASSERT_EQ("c", myvec[1]);
+	ASSERT_EQ(0, myvec2.size());
+	ASSERT_EQ(stats_t(2, 1, 3, 1), stats);
+	ASSERT_EQ(stats_t(1, 0, 2, 2), stats2);
+}
+
+TEST(aligned_allocator_test, alignment)
+{
+	for(unsigned int c : { 1, 3, 16, 17, 1000 })
+	{
+		aligned_fixed_capacity_vector<int> ints(c);
+		aligned_fixed_capacity_vector<char> chars(c);
+		aligned_fixed_capacity_vector<std::string> strings(c);
+		aligned_fixed_capacity_vector<double, 32> doubles(c);
+		ASSERT_EQ(0, reinterpret_cast<std::uintptr_t>(ints.data()) % 64);
+		ASSERT_EQ(0, reinterpret_cast<std::uintptr_t>(chars.data()) % 64);
+		ASSERT_EQ(0, reinterpret_cast<std::uintptr_t>(strings.data()) % 64);
+		ASSERT_EQ(0, reinterpret_cast<std::uintptr_t>(doubles.data()) % 32);
+
+		ints.resize(c, 3);
+		strings.resize(c, "abc");
+		auto copy = strings;
+		ASSERT_EQ(0, reinterpret_cast<std::uintptr_t>(copy.data()) % 64);
+		ASSERT_EQ(true, std::equal(strings.begin(), strings.end(), copy.begin()));
+	}
+
+	ASSERT_EQ(aligned_allocator<int>(), aligned_allocator<char>());
+}
+
+TEST(aligned_allocator_test, padded_capacity)
+{
+	// 64 byte lanes
+	ASSERT_EQ(0, aligned_allocator<int>::padded_capacity(0));
+	ASSERT_EQ(16, aligned_allocator<int>::padded_capacity(1));
+	ASSERT_EQ(16, aligned_allocator<int>::padded_capacity(16));
+	ASSERT_EQ(32, aligned_allocator<int>::padded_capacity(17));
+	ASSERT_EQ(8, aligned_allocator<void*>::padded_capacity(5));
+	// AVX2 lanes
+	ASSERT_EQ(16, aligned_allocator<int>::padded_capacity(13, 32));
+	ASSERT_EQ(32, aligned_allocator<char>::padded_capacity(13, 32));
+	// element sizes that do not divide the lane width are not padded
+	ASSERT_EQ(13, (aligned_allocator<std::array<char, 3>>::padded_capacity(13)));
+
+	aligned_fixed_capacity_vector<int> myvec(aligned_allocator<int>::padded_capacity(100));
+	ASSERT_EQ(112, myvec.capacity());
+}
+
+TEST(arena_allocator_test, allocate_from_buffer)
+{
+	alignas(64) char buffer[1024];
+	arena a(buffer, sizeof(buffer));
+	{
+		fixed_capacity_vector<int, arena_allocator<int>> ints(16, a);
+		fixed_capacity_vector<std::string, arena_allocator<std::string>> strings(4, a);
+		ints.resize(16, 7);
+		strings.push_back("abc");
+
+		// both buffers come from the arena
+		ASSERT_EQ(true, reinterpret_cast<char*>(ints.data()) >= buffer && reinterpret_cast<char*>(ints.data() + 16) <= buffer + sizeof(buffer));
+		ASSERT_EQ(true, reinterpret_cast<char*>(strings.data()) >= buffer && reinterpret_cast<char*>(strings.data() + 4) <= buffer + sizeof(buffer));
+		ASSERT_EQ(0, reinterpret_cast<std::uintptr_t>(strings.data()) % alignof(std::string));
+		ASSERT_EQ(16 * sizeof(int) + 4 * sizeof(std::string), a.bytes_used());
+		ASSERT_EQ(0, a.block_count());
+
+		// without upstream fallback an exhausted arena throws
+		ASSERT_THROW((fixed_capacity_vector<int, arena_allocator<int>>(1024, a)), std::bad_alloc);
+	}
+	// the most recent allocation is rolled back on deallocation, the vectors are
+	// destroyed in reverse order so both buffers are given back
+	ASSERT_EQ(0, a.bytes_used());
+	{
+		fixed_capacity_vector<int, arena_allocator<int>> ints(16, a);
+		fixed_capacity_vector<int, arena_allocator<int>> ints2(16, a);
+		ints = fixed_capacity_vector<int, arena_allocator<int>>(4, a);
+		// the memory of the replaced buffer is only available after reset()
+		ASSERT_EQ(36 * sizeof(int), a.bytes_used());
+	}
+	a.reset();
+	ASSERT_EQ(0, a.bytes_used());
+	fixed_capacity_vector<int, arena_allocator<int>> ints(16, a);
+	ASSERT_EQ(reinterpret_cast<int*>(buffer), ints.data());
+}
+
+TEST(arena_allocator_test, upstream_blocks)
+{
+	char buffer[64];
+	arena a(buffer, sizeof(buffer), true, 256);
+	std::vector<int*> data;
+	for(int round=0; round<3; ++round)
+	{
+		{
+			fixed_capacity_vector<int, arena_allocator<int>> small(8, a);
+			fixed_capacity_vector<int, arena_allocator<int>> medium(32, a);
+			fixed_capacity_vector<int, arena_allocator<int>> large(1000, a);
+			small.resize(8, 1);
+			medium.resize(32, 2);
+			large.resize(1000, 3);
+			ASSERT_EQ(reinterpret_cast<int*>(buffer), small.data());
+			ASSERT_EQ(8, std::count(small.begin(), small.end(), 1));
+			ASSERT_EQ(32, std::count(medium.begin(), medium.end(), 2));
+			ASSERT_EQ(1000, std::count(large.begin(), large.end(), 3));
+			ASSERT_EQ(2, a.block_count());
+			if(round)
+			{
+				// blocks are retained across reset()
+				ASSERT_EQ(data[0], medium.data());
+				ASSERT_EQ(data[1], large.data());
+			}
+			else
+			{
+				data.push_back(medium.data());
+				data.push_back(large.data());
+			}
+		}
+		a.reset();
+	}
+	a.release();
+	ASSERT_EQ(0, a.block_count());
+
+	// arena without initial buffer
+	arena b(128);
+	fixed_capacity_vector<double, arena_allocator<double>> doubles(100, b);
+	doubles.resize(100, 1.5);
+	ASSERT_EQ(1, b.block_count());
+	ASSERT_EQ(0, reinterpret_cast<std::uintptr_t>(doubles.data()) % alignof(double));
+}
+
+TEST(arena_allocator_test, propagation)
+{
+	arena a, b;
+	typedef fixed_capacity_vector<std::string, arena_allocator<std::string>> vector_t;
+
+	ASSERT_EQ(arena_allocator<int>(a), arena_allocator<std::string>(a));
+	ASSERT_NE(arena_allocator<int>(a), arena_allocator<int>(b));
+
+	vector_t myvec(4, a), myvec2(8, b);
+	myvec.push_back("a");
+	myvec2.push_back("b");
+
+	// move assignment takes over the buffer together with its allocator
+	auto buffer2 = myvec2.data();
+	myvec = std::move(myvec2);
+	ASSERT_EQ(buffer2, myvec.data());
+	ASSERT_EQ(arena_allocator<std::string>(b), myvec.get_allocator());
+
+	// swap exchanges buffers and allocators
+	vector_t myvec3(2, a);
+	myvec3.swap(myvec);
+	ASSERT_EQ(buffer2, myvec3.data());
+	ASSERT_EQ(arena_allocator<std::string>(b), myvec3.get_allocator());
+	ASSERT_EQ(arena_allocator<std::string>(a), myvec.get_allocator());
+
+	// copy assignment keeps allocating from the own arena
+	vector_t myvec4(1, a);
+	myvec4 = myvec3;
+	ASSERT_EQ(arena_allocator<std::string>(a), myvec4.get_allocator());
+	ASSERT_EQ("b", myvec4[0]);
+
+	// copy construction shares the arena of the source
+	vector_t myvec5(myvec3);
+	ASSERT_EQ(arena_allocator<std::string>(b), myvec5.get_allocator());
+}
+
+TEST(pool_allocator_test, recycle_blocks)
+{
+	typedef fixed_capacity_vector<std::string, pool_allocator<std::string>> vector_t;
+	block_pool pool(16 * sizeof(std::string), 4);
+	ASSERT_EQ(0, pool.slab_count());
+
+	{
+		std::vector<vector_t> vectors;
+		for(int i=0; i<10; ++i)
+		{
+			vectors.emplace_back(16, pool);
+			vectors.back().push_back(std::string(i, 'x'));
+		}
+		ASSERT_EQ(3, pool.slab_count());
+		ASSERT_EQ(10, pool.blocks_in_use());
+		ASSERT_EQ(2, pool.blocks_free());
+		ASSERT_DOUBLE_EQ(10.0 / 12.0, pool.occupancy());
+		for(int i=0; i<10; ++i)
+		{
+			ASSERT_EQ(std::string(i, 'x'), vectors[i][0]);
+			ASSERT_EQ(0, reinterpret_cast<std::uintptr_t>(vectors[i].data()) % alignof(std::string));
+		}
+
+		// a freed block is handed out again right away
+		auto freed = vectors[4].data();
+		vectors.erase(vectors.begin() + 4);
+		ASSERT_EQ(9, pool.blocks_in_use());
+		vectors.emplace_back(8, pool);
+		ASSERT_EQ(freed, vectors.back().data());
+		ASSERT_EQ(3, pool.slab_count());
+	}
+	ASSERT_EQ(0, pool.blocks_in_use());
+	ASSERT_EQ(12, pool.blocks_free());
+	ASSERT_DOUBLE_EQ(0.0, pool.occupancy());
+
+	// capacities beyond the block size fall back to operator new
+	vector_t large(17, pool);
+	large.resize(17, "abc");
+	ASSERT_EQ(0, pool.blocks_in_use());
+}
+
+TEST(pool_allocator_test, alignment)
+{
+	block_pool pool(48, 8, 64);
+	fixed_capacity_vector<double, pool_allocator<double>> a(6, pool), b(6, pool), c(1, pool);
+	ASSERT_EQ(0, reinterpret_cast<std::uintptr_t>(a.data()) % 64);
+	ASSERT_EQ(0, reinterpret_cast<std::uintptr_t>(b.data()) % 64);
+	ASSERT_EQ(0, reinterpret_cast<std::uintptr_t>(c.data()) % 64);
+	ASSERT_EQ(3, pool.blocks_in_use());
+}
+
+TEST(pool_allocator_test, thread_local_pools)
+{
+	typedef fixed_capacity_vector<int, pool_allocator<int>> vector_t;
+	block_pool* mainPool = &thread_local_block_pool<64 * sizeof(int)>();
+	ASSERT_EQ(mainPool, &thread_local_block_pool<64 * sizeof(int)>());
+
+	block_pool* workerPool = nullptr;
+	std::size_t workerInUse = 0;
+	std::thread worker([&]() {
+		workerPool = &thread_local_block_pool<64 * sizeof(int)>();
+		vector_t v(64, *workerPool);
+		v.resize(64, 1);
+		workerInUse = workerPool->blocks_in_use();
+	});
+	worker.join();
+	ASSERT_NE(mainPool, workerPool);
+	ASSERT_EQ(1, workerInUse);
+
+	vector_t v(64, *mainPool);
+	ASSERT_EQ(1, mainPool->blocks_in_use());
+	ASSERT_EQ(pool_allocator<int>(*mainPool), v.get_allocator());
+}
+
+// runs the kernels of every instruction set the CPU supports against the scalar ones,
+// for all lengths around the register widths and every match position
+template<typename U>
+void check_simd_kernels()
+{
+	const int active = static_cast<int>(fcv_simd::active_instruction_set());
+	for(int set = 0; set <= active; ++set)
+	{
+		const auto k = fcv_simd::detail::kernels_for<U>(static_cast<fcv_simd::instruction_set>(set));
+		std::vector<U> buffer(300 + 2, U(7));
+		for(std::size_t n = 0; n < 300; n += (n < 70 ? 1 : 37))
+		{
+			// unaligned start
+			U* p = buffer.data() + 1;
+			std::fill(p, p + n, U(7));
+			ASSERT_EQ(n, k.find(p, n, U(3)));
+			ASSERT_EQ(0, k.count(p, n, U(3)));
+			for(std::size_t i = n; i-- > 0;)
+			{
+				p[i] = U(3);
+				ASSERT_EQ(i, k.find(p, n, U(3)));
+				ASSERT_EQ(n - i, k.count(p, n, U(3)));
+			}
+
+			// fill must not touch the elements around the range
+			p[n] = U(9);
+			k.fill(p, n, U(5));
+			ASSERT_EQ(n, static_cast<std::size_t>(std::count(p, p + n, U(5))));
+			ASSERT_EQ(U(7), buffer.front());
+			ASSERT_EQ(U(9), p[n]);
+		}
+	}
+}
+
+TEST(simd_algorithms_test, kernels)
+{
+	check_simd_kernels<std::uint8_t>();
+	check_simd_kernels<std::uint16_t>();
+	check_simd_kernels<std::uint32_t>();
+	check_simd_kernels<std::uint64_t>();
+}
+
+TEST(simd_algorithms_test, container)
+{
+	fixed_capacity_vector<int> ints(1000);
+	for(int i = 0; i < 1000; ++i)
+		ints.push_back(i % 100);
+	ASSERT_EQ(ints.begin() + 42, fcv_simd::find(ints, 42));
+	ASSERT_EQ(ints.end(), fcv_simd::find(ints, 100));
+	ASSERT_EQ(10, fcv_simd::count(ints, 42));
+	ASSERT_EQ(true, fcv_simd::contains(ints, 99));
+	ASSERT_EQ(false, fcv_simd::contains(ints, -1));
+	ASSERT_EQ(57, fcv_simd::index_of(ints, 57));
+	ASSERT_EQ(-1, fcv_simd::index_of(ints, 1000));
+	fcv_simd::fill(ints, -3);
+	ASSERT_EQ(1000, std::count(ints.begin(), ints.end(), -3));
+
+	int objects[3];
+	fixed_capacity_vector<void*> pointers(100);
+	pointers.resize(99, &objects[0]);
+	pointers.push_back(&objects[1]);
+	const auto& cpointers = pointers;
+	ASSERT_EQ(cpointers.begin() + 99, fcv_simd::find(cpointers, &objects[1]));
+	ASSERT_EQ(99, fcv_simd::count(pointers, &objects[0]));
+	ASSERT_EQ(false, fcv_simd::contains(pointers, &objects[2]));
+	ASSERT_EQ(99, fcv_simd::index_of(pointers, &objects[1]));
+	fcv_simd::fill(pointers, nullptr);
+	ASSERT_EQ(100, fcv_simd::count(pointers, nullptr));
+
+	// floating point uses operator==, so -0.0 matches 0.0
+	fixed_capacity_vector<double> doubles(10);
+	doubles.resize(10, 1.0);
+	doubles[4] = -0.0;
+	ASSERT_EQ(4, fcv_simd::index_of(doubles, 0.0));
+
+	fixed_capacity_vector<std::string> strings(10);
+	strings.resize(10, "a");
+	strings[6] = "b";
+	ASSERT_EQ(6, fcv_simd::index_of(strings, "b"));
+	fcv_simd::fill(strings, "c");
+	ASSERT_EQ(10, fcv_simd::count(strings, "c"));
+
+	fixed_capacity_vector<int> empty(0);
+	ASSERT_EQ(empty.end(), fcv_simd::find(empty, 0));
+	ASSERT_EQ(-1, fcv_simd::index_of(empty, 0));
+}
+
+TEST(concurrent_append_vector_test, single_thread)
+{
+	concurrent_append_vector<std::string> v(3);
+	ASSERT_EQ(true, v.empty());
+	ASSERT_EQ(0, v.push_back("a"));
+	ASSERT_EQ(1, v.emplace_back(2, 'b'));
+	ASSERT_EQ(true, v.try_emplace_back("c"));
+	ASSERT_EQ(true, v.full());
+	ASSERT_EQ(false, v.try_emplace_back("d"));
+	ASSERT_THROW(v.push_back("d"), std::length_error);
+	ASSERT_EQ(3, v.size());
+	ASSERT_EQ("bb", v[1]);
+	ASSERT_EQ(3, std::distance(v.begin(), v.end()));
+
+	v.clear();
+	ASSERT_EQ(true, v.empty());
+	ASSERT_EQ(false, v.full());
+	ASSERT_EQ(0, v.push_back("e"));
+	ASSERT_EQ("e", v[0]);
+
+	concurrent_append_vector<int> none(0);
+	ASSERT_EQ(false, none.try_emplace_back(1));
+}
+
+// producers append values encoding their thread and sequence number while a reader
+// checks that every published element is fully constructed
+TEST(concurrent_append_vector_test, stress)
+{
+	const unsigned int producers = 8, perProducer = 20000;
+	const unsigned int capacity = producers * perProducer - 1000;
+	concurrent_append_vector<std::pair<unsigned int, std::string>> v(capacity);
+
+	std::atomic<bool> done(false);
+	std::atomic<unsigned int> rejected(0);
+	std::atomic<bool> readerOk(true);
+	std::thread reader([&]()
+	{
+		unsigned int checked = 0;
+		while(!done.load() || checked < v.size())
+		{
+			const unsigned int size = v.size();
+			for(; checked < size; ++checked)
+				if(v[checked].second != std::to_string(v[checked].first))
+					readerOk = false;
+		}
+	});
+
+	std::vector<std::thread> threads;
+	for(unsigned int t = 0; t < producers; ++t)
+		threads.emplace_back([&, t]()
+		{
+			for(unsigned int i = 0; i < perProducer; ++i)
+			{
+				const unsigned int id = t * perProducer + i;
+				if(!v.try_emplace_back(id, std::to_string(id)))
+					++rejected;
+			}
+		});
+	for(auto& thread : threads)
+		thread.join();
+	done = true;
+	reader.join();
+
+	ASSERT_EQ(true, readerOk.load());
+	ASSERT_EQ(capacity, v.size());
+	ASSERT_EQ(producers * perProducer - capacity, rejected.load());
+
+	// every value appears at most once and the values of each producer keep their order
+	std::vector<bool> seen(producers * perProducer);
+	std::vector<int> last(producers, -1);
+	for(const auto& element : v)
+	{
+		ASSERT_EQ(false, seen[element.first]);
+		seen[element.first] = true;
+		const unsigned int t = element.first / perProducer;
+		ASSERT_LT(last[t], static_cast<int>(element.first % perProducer));
+		last[t] = static_cast<int>(element.first % perProducer);
+	}
+}
+
+TEST(ring_buffer_test, both_ends)
+{
+	AllocatorMock<std::string>::Statistics stats;
+	{
+		fixed_capacity_ring_buffer<std::string, AllocatorMock<std::string>> ring(4, AllocatorMock<std::string>(&stats));
+		ring.push_back("b");
+		ring.push_front("a");
+		ring.emplace_back(1, 'c');
+		ring.emplace_front("z");
+		ASSERT_EQ(true, ring.full());
+		ASSERT_THROW(ring.push_back("x"), std::length_error);
+		ASSERT_THROW(ring.push_front("x"), std::length_error);
+		const std::array<std::string, 4> expected = { { "z", "a", "b", "c" } };
+		ASSERT_EQ(true, std::equal(ring.begin(), ring.end(), expected.begin()));
+		ASSERT_EQ(true, std::equal(ring.rbegin(), ring.rend(), expected.rbegin()));
+		ASSERT_EQ("z", ring.front());
+		ASSERT_EQ("c", ring.back());
+		ASSERT_EQ("b", ring[2]);
+
+		ring.pop_front();
+		ring.pop_back();
+		ASSERT_EQ(2, ring.size());
+		ASSERT_EQ("a", ring.front());
+		ASSERT_EQ("b", ring.back());
+		ASSERT_EQ(AllocatorCallStatistics(1, 0, 4, 2), stats);
+	}
+	ASSERT_EQ(AllocatorCallStatistics(1, 1, 4, 4), stats);
+}
+
+// random operations at both ends against std::deque, wrapping around many times
+TEST(ring_buffer_test, against_deque)
+{
+	fixed_capacity_ring_buffer<int> ring(7);
+	std::deque<int> reference;
+	unsigned int state = 1;
+	for(int i = 0; i < 10000; ++i)
+	{
+		state = state * 1103515245 + 12345;
+		const unsigned int op = (state >> 16) % 4;
+		if(op < 2 && !ring.full())
+		{
+			if(op == 0) { ring.push_back(i); reference.push_back(i); }
+			else { ring.push_front(i); reference.push_front(i); }
+		}
+		else if(op >= 2 && !ring.empty())
+		{
+			if(op == 2) { ring.pop_back(); reference.pop_back(); }
+			else { ring.pop_front(); reference.pop_front(); }
+		}
+		ASSERT_EQ(reference.size(), ring.size());
+		ASSERT_EQ(true, std::equal(reference.begin(), reference.end(), ring.begin()));
+	}
+
+	const auto& cring = ring;
+	fixed_capacity_ring_buffer<int>::const_iterator it = ring.begin();
+	ASSERT_EQ(cring.begin(), it);
+	ASSERT_EQ(static_cast<std::ptrdiff_t>(ring.size()), cring.end() - it);
+	if(!ring.empty())
+	{
+		ASSERT_EQ(ring.back(), it[ring.size() - 1]);
+	}
+}
+
+TEST(ring_buffer_test, copy_move_swap)
+{
+	fixed_capacity_ring_buffer<std::string> ring(3);
+	ring.push_back("b");
+	ring.push_back("c");
+	ring.pop_front();
+	ring.push_back("d");
+	ring.push_front("a");	// wrapped around
+
+	fixed_capacity_ring_buffer<std::string> copy(ring);
+	ASSERT_EQ(true, std::equal(ring.begin(), ring.end(), copy.begin()));
+	fixed_capacity_ring_buffer<std::string> other(1);
+	other = copy;
+	ASSERT_EQ(3, other.capacity());
+	ASSERT_EQ("d", other.back());
+
+	fixed_capacity_ring_buffer<std::string> moved(std::move(copy));
+	ASSERT_EQ(0, copy.capacity());
+	ASSERT_EQ("a", moved.front());
+
+	other.clear();
+	other.push_back("x");
+	swap(other, moved);
+	ASSERT_EQ(1, moved.size());
+	ASSERT_EQ(3, other.size());
+	moved = std::move(other);
+	ASSERT_EQ(3, moved.size());
+	ASSERT_EQ("c", moved[1]);
+}
+
+// the producer and consumer indices are padded apart by whole cache lines, which
+// needs no over-aligned allocation
+static_assert(alignof(spsc_ring_buffer<int>) <= alignof(std::max_align_t) && sizeof(spsc_ring_buffer<int>) >= 3 * 64, "");
+
+TEST(spsc_ring_buffer_test, single_thread)
+{
+	auto tracked = std::make_shared<int>(0);
+	{
+		spsc_ring_buffer<std::shared_ptr<int>> queue(2);
+		ASSERT_EQ(2, queue.capacity());
+		ASSERT_EQ(true, queue.empty());
+		ASSERT_EQ(true, queue.try_push(tracked));
+		ASSERT_EQ(true, queue.try_emplace(tracked));
+		ASSERT_EQ(false, queue.try_push(tracked));
+		ASSERT_EQ(2, queue.size_approx());
+
+		std::shared_ptr<int> out;
+		ASSERT_EQ(true, queue.try_pop(out));
+		ASSERT_EQ(tracked, out);
+		out.reset();
+		ASSERT_EQ(true, queue.try_push(tracked));
+		ASSERT_EQ(3, tracked.use_count());
+	}
+	// elements left in the queue are destroyed with it
+	ASSERT_EQ(1, tracked.use_count());
+}
+
+TEST(spsc_ring_buffer_test, producer_consumer)
+{
+	const unsigned int count = 200000;
+	spsc_ring_buffer<std::string> queue(64);
+	std::thread producer([&]()
+	{
+		for(unsigned int i = 0; i < count; ++i)
+			while(!queue.try_emplace(std::to_string(i)))
+				std::this_thread::yield();
+	});
+
+	bool inOrder = true;
+	for(unsigned int i = 0; i < count; ++i)
+	{
+		std::string* p;
+		while(!(p = queue.front()))
+			std::this_thread::yield();
+		inOrder = inOrder && *p == std::to_string(i);
+		queue.pop();
+	}
+	producer.join();
+	ASSERT_EQ(true, inOrder);
+	ASSERT_EQ(true, queue.empty());
+}
+
+TEST(soa_vector_test, columns)
+{
+	fixed_capacity_soa_vector<short, short> pairs(100);
+	ASSERT_EQ(2, (fixed_capacity_soa_vector<short, short>::column_count));
+	for(short i = 0; i < 100; ++i)
+		pairs.push_back(std::make_tuple(i, static_cast<short>(-i)));
+	ASSERT_EQ(true, pairs.full());
+	ASSERT_THROW(pairs.emplace_back(1, 2), std::length_error);
+
+	// each column is contiguous and starts on a cache line
+	ASSERT_EQ(0, reinterpret_cast<std::uintptr_t>(pairs.data<0>()) % 64);
+	ASSERT_EQ(0, reinterpret_cast<std::uintptr_t>(pairs.data<1>()) % 64);
+	auto firsts = pairs.column<0>();
+	ASSERT_EQ(100, firsts.size());
+	ASSERT_EQ(4950, std::accumulate(firsts.begin(), firsts.end(), 0));
+	ASSERT_EQ(-4950, std::accumulate(pairs.data<1>(), pairs.data<1>() + pairs.size(), 0));
+
+	std::get<1>(pairs[10]) = 7;
+	ASSERT_EQ(7, pairs.data<1>()[10]);
+	ASSERT_EQ(std::make_tuple(short(99), short(-99)), pairs.back());
+
+	// zip iteration
+	int sum = 0;
+	for(auto row : pairs)
+		sum += std::get<0>(row) * std::get<1>(row);
+	ASSERT_EQ(-328350 + 10 * 10 + 10 * 7, sum);
+	fixed_capacity_soa_vector<short, short>::const_iterator it = pairs.begin();
+	ASSERT_EQ(100, pairs.cend() - it);
+	ASSERT_EQ(std::make_tuple(short(3), short(-3)), it[3]);
+}
+
+TEST(soa_vector_test, non_trivial_columns)
+{
+	typedef fixed_capacity_soa_vector<std::string, int, std::vector<char>> soa_t;
+	soa_t v(4);
+	v.emplace_back("a", 1, std::vector<char>(3, 'x'));
+	v.push_back(std::make_tuple(std::string("bb"), 2, std::vector<char>()));
+	ASSERT_EQ("bb", std::get<0>(v[1]));
+
+	soa_t copy(v);
+	soa_t assigned(1);
+	assigned = copy;
+	ASSERT_EQ(2, assigned.size());
+	ASSERT_EQ(4, assigned.capacity());
+	ASSERT_EQ(3, std::get<2>(assigned[0]).size());
+
+	soa_t moved(std::move(copy));
+	ASSERT_EQ(0, copy.capacity());
+	ASSERT_EQ(2, moved.size());
+	moved.pop_back();
+	ASSERT_EQ(1, moved.size());
+	swap(moved, assigned);
+	ASSERT_EQ(2, moved.size());
+	moved.clear();
+	ASSERT_EQ(true, moved.empty());
+}
+
+namespace
+{
+	struct alignas(256) over_aligned
+	{
+		int value;
+	};
+}
+
+TEST(soa_vector_test, over_aligned_columns)
+{
+	// the heap only guarantees a cache line or less, so try a few allocations
+	for(unsigned int capacity = 1; capacity < 8; ++capacity)
+	{
+		fixed_capacity_soa_vector<char, over_aligned, short> v(capacity);
+		ASSERT_EQ(0, reinterpret_cast<std::uintptr_t>(v.data<0>()) % 64);
+		ASSERT_EQ(0, reinterpret_cast<std::uintptr_t>(v.data<1>()) % 256);
+		ASSERT_EQ(0, reinterpret_cast<std::uintptr_t>(v.data<2>()) % 64);
+	}
+}
+
+namespace
+{
+	struct throws_on_negative
+	{
+		static int alive;
+		throws_on_negative(int i) { if(i < 0) throw std::runtime_error("negative"); ++alive; }
+		throws_on_negative(const throws_on_negative&) { ++alive; }
+		~throws_on_negative() { --alive; }
+	};
+	int throws_on_negative::alive = 0;
+}
+
+TEST(soa_vector_test, construction_rolls_back)
+{
+	{
+		fixed_capacity_soa_vector<throws_on_negative, std::string, throws_on_negative> v(2);
+		v.emplace_back(1, "a", 1);
+		ASSERT_EQ(2, throws_on_negative::alive);
+		// the first two columns are destroyed again when the third one throws
+		ASSERT_THROW(v.emplace_back(1, "b", -1), std::runtime_error);
+		ASSERT_EQ(1, v.size());
+		ASSERT_EQ(2, throws_on_negative::alive);
+	}
+	ASSERT_EQ(0, throws_on_negative::alive);
+}
+
+namespace
+{
+	// non-trivially copyable type that opts into relocation and counts the
+	// move operations and destructor calls the containers still make
+	struct relocatable_counter
+	{
+		static int moves;
+		static int destroys;
+
+		relocatable_counter(int v = 0) : value(new int(v)) {}
+		relocatable_counter(const relocatable_counter& other) : value(new int(*other.value)) {}
+		relocatable_counter(relocatable_counter&& other) : value(std::move(other.value)) { ++moves; }
+		relocatable_counter& operator=(const relocatable_counter& other) { value.reset(new int(*other.value)); return *this; }
+		relocatable_counter& operator=(relocatable_counter&& other) { value = std::move(other.value); ++moves; return *this; }
+		~relocatable_counter() { ++destroys; }
+
+		static void reset() { moves = 0; destroys = 0; }
+
+		std::unique_ptr<int> value;
+	};
+	int relocatable_counter::moves = 0;
+	int relocatable_counter::destroys = 0;
+}
+
+template<>
+struct is_trivially_relocatable<relocatable_counter> : std::true_type
+{
+};
+
+TEST(relocation_test, trait)
+{
+	static_assert(is_trivially_relocatable<int>::value, "");
+	static_assert(is_trivially_relocatable<std::pair<short, short>>::value, "");
+	static_assert(is_trivially_relocatable<std::vector<char>>::value, "");
+	static_assert(is_trivially_relocatable<std::unique_ptr<int>>::value, "");
+	static_assert(is_trivially_relocatable<std::shared_ptr<int>>::value, "");
+	static_assert(is_trivially_relocatable<std::pair<int, std::vector<char>>>::value, "");
+	static_assert(!is_trivially_relocatable<std::function<void()>>::value, "");
+	static_assert(!is_trivially_relocatable<std::vector<char, AllocatorMock<char>>>::value, "");
+	static_assert(!is_trivially_relocatable<std::pair<int, std::function<void()>>>::value, "");
+}
+
+TEST(relocation_test, insert_erase_skip_moves)
+{
+	fixed_capacity_vector<relocatable_counter> v(10);
+	for(int i = 0; i < 8; ++i)
+		v.emplace_back(i);
+	relocatable_counter::reset();
+
+	const relocatable_counter value(42);
+	v.insert(v.begin(), value);
+	v.insert(v.begin() + 4, { relocatable_counter(43) });
+	ASSERT_EQ(0, relocatable_counter::moves);
+	v.erase(v.begin() + 2);
+	v.erase(v.begin(), v.begin() + 2);
+	v.erase_unordered(v.begin());
+	ASSERT_EQ(0, relocatable_counter::moves);
+	// the temporary of the initializer_list and the four erased elements
+	ASSERT_EQ(5, relocatable_counter::destroys);
+
+	const int expected[] = { 7, 43, 3, 4, 5, 6 };
+	ASSERT_EQ(6, v.size());
+	for(unsigned int i = 0; i < v.size(); ++i)
+		ASSERT_EQ(expected[i], *v[i].value);
+}
+
+TEST(relocation_test, static_vector_relocates_buffer)
+{
+	static_vector<relocatable_counter, 8> a;
+	for(int i = 0; i < 5; ++i)
+		a.emplace_back(i);
+	relocatable_counter::reset();
+
+	static_vector<relocatable_counter, 8> b(std::move(a));
+	ASSERT_EQ(0, a.size());
+	ASSERT_EQ(5, b.size());
+
+	static_vector<relocatable_counter, 8> c;
+	c.emplace_back(9);
+	relocatable_counter::reset();
+	c.swap(b);
+	ASSERT_EQ(1, b.size());
+	ASSERT_EQ(5, c.size());
+	ASSERT_EQ(9, *b[0].value);
+	ASSERT_EQ(4, *c[4].value);
+
+	b = std::move(c);
+	ASSERT_EQ(0, relocatable_counter::moves);
+	ASSERT_EQ(1, relocatable_counter::destroys);
+	ASSERT_EQ(5, b.size());
+	ASSERT_EQ(0, c.size());
+	ASSERT_EQ(3, *b[3].value);
+}
+
+// a stateless allocator takes no space, the object is the buffer pointer plus size and capacity
+static_assert(sizeof(void*) != 8 || sizeof(fixed_capacity_vector<int>) == 16, "");
+static_assert(sizeof(void*) != 8 || sizeof(fixed_capacity_vector<int, std::allocator<int>, std::uint8_t>) == 16, "");
+static_assert(sizeof(void*) != 8 || sizeof(fixed_capacity_vector<int, std::allocator<int>, std::uint16_t>) == 16, "");
+static_assert(sizeof(void*) != 8 || sizeof(fixed_capacity_vector<int, std::allocator<int>, std::size_t>) == 24, "");
+static_assert(sizeof(void*) != 8 || sizeof(aligned_fixed_capacity_vector<int>) == 16, "");
+static_assert(sizeof(void*) != 8 || sizeof(fixed_capacity_vector<int, arena_allocator<int>>) == 24, "");
+static_assert(sizeof(void*) != 8 || sizeof(fixed_capacity_vector<int, pool_allocator<int>, std::uint16_t>) == 24, "");
+static_assert(sizeof(fixed_capacity_vector<int, std::allocator<int>, std::uint8_t>) <= 2 * sizeof(void*), "");
+
+TEST(fcv_size_type_test, limits)
+{
+	fixed_capacity_vector<int, std::allocator<int>, std::uint8_t> tiny(255);
+	ASSERT_EQ(255, tiny.max_size());
+	tiny.resize(255, 1);
+	ASSERT_EQ(255, tiny.size());
+	ASSERT_THROW(tiny.push_back(2), std::length_error);
+
+	ASSERT_EQ(65535, (fixed_capacity_vector<int, std::allocator<int>, std::uint16_t>(0).max_size()));
+	ASSERT_EQ((std::allocator_traits<std::allocator<int>>::max_size(std::allocator<int>())),
+		(fixed_capacity_vector<int, std::allocator<int>, std::size_t>(0).max_size()));
+
+	// capacities beyond what the allocator can serve are rejected before allocating
+	typedef std::array<char, 1 << 20> block;
+	const std::size_t tooMany = std::allocator_traits<std::allocator<block>>::max_size(std::allocator<block>()) + 1;
+	ASSERT_THROW((fixed_capacity_vector<block, std::allocator<block>, std::size_t>(tooMany)), std::length_error);
+
+	fixed_capacity_vector<std::string, std::allocator<std::string>, std::uint16_t> a(3), b(5);
+	a.push_back("a");
+	swap(a, b);
+	ASSERT_EQ(3, b.capacity());
+	ASSERT_EQ("a", b[0]);
+}
+
+namespace
+{
+	struct mapped_record
+	{
+		int id;
+		double value;
+		char tag[4];
+	};
+
+	// unique path in the temp directory, removed again on destruction
+	class temp_file
+	{
+	public:
+		temp_file()
+		{
+			char pattern[] = "/tmp/gsoc_vector_test_XXXXXX";
+			const int fd = ::mkstemp(pattern);
+			if(fd >= 0)
+				::close(fd);
+			path_ = pattern;
+		}
+
+		~temp_file()
+		{
+			::unlink(path_.c_str());
+		}
+
+		const std::string& path() const { return path_; }
+
+	private:
+		std::string path_;
+	};
+}
+
+TEST(mapped_vector_test, create_and_reopen)
+{
+	temp_file file;
+	{
+		mapped_vector<mapped_record> v(file.path(), 1000);
+		ASSERT_EQ(1000, v.get().capacity());
+		for(int i = 0; i < 600; ++i)
+		{
+			const mapped_record r = { i, i * 0.5, { 'a', 'b', 'c', 0 } };
+			v.get().push_back(r);
+		}
+		ASSERT_EQ(0, reinterpret_cast<std::uintptr_t>(v.get().data()) % 64);
+	}
+	{
+		const mapped_vector<mapped_record> v(file.path(), mapped_file_mode::read_only);
+		ASSERT_EQ(false, v.writable());
+		ASSERT_EQ(600, v.get().size());
+		ASSERT_EQ(1000, v.get().capacity());
+		for(int i = 0; i < 600; ++i)
+		{
+			ASSERT_EQ(i, v.get()[i].id);
+			ASSERT_EQ(i * 0.5, v.get()[i].value);
+		}
+	}
+	{
+		mapped_vector<mapped_record> v(file.path(), mapped_file_mode::read_write);
+		v.get().erase(v.get().begin(), v.get().begin() + 100);
+		v.get().resize(700, mapped_record());
+		v.sync();
+		ASSERT_EQ(700, mapped_file(file.path(), mapped_file_mode::read_only, sizeof(mapped_record)).stored_size());
+		v.get().pop_back();
+	}
+	{
+		const mapped_vector<mapped_record> v(file.path(), mapped_file_mode::read_only);
+		ASSERT_EQ(699, v.get().size());
+		ASSERT_EQ(100, v.get()[0].id);
+		ASSERT_EQ(0, v.get()[698].id);
+	}
+}
+
+TEST(mapped_vector_test, rejects_invalid_files)
+{
+	temp_file file;
+	ASSERT_THROW(mapped_vector<int>(file.path(), mapped_file_mode::read_only), std::runtime_error);
+	ASSERT_THROW(mapped_vector<int>("/nonexistent/dir/file", mapped_file_mode::read_write), std::system_error);
+
+	{
+		mapped_vector<int> v(file.path(), 10);
+		v.get().push_back(1);
+	}
+	// other element size
+	ASSERT_THROW(mapped_vector<std::int64_t>(file.path(), mapped_file_mode::read_only), std::runtime_error);
+
+	// truncated data
+	ASSERT_EQ(0, ::truncate(file.path().c_str(), mapped_file_header::data_offset + 5 * sizeof(int)));
+	ASSERT_THROW(mapped_vector<int>(file.path(), mapped_file_mode::read_write), std::runtime_error);
+}
+
+TEST(mapped_vector_test, single_owner)
+{
+	temp_file file;
+	mapped_vector<int> v(file.path(), 4);
+	v.get().assign({ 1, 2, 3 });
+
+	// a copy cannot share the mapped buffer
+	ASSERT_THROW(mapped_vector<int>::container_type copy(v.get()), std::bad_alloc);
+	ASSERT_EQ(3, v.get().size());
+
+	// a plain fixed_capacity_vector can take the elements out of the mapping
+	fixed_capacity_vector<int> plain(4);
+	plain.assign(v.get().begin(), v.get().end());
+	ASSERT_EQ(3, plain[2]);
+}
+
+namespace
+{
+	// unique shared memory name, removed again on destruction
+	class temp_segment_name
+	{
+	public:
+		temp_segment_name()
+			: name_("/gsoc_vector_test_" + std::to_string(::getpid()) + "_" + std::to_string(counter()++))
+		{
+		}
+
+		~temp_segment_name()
+		{
+			shared_memory_segment::remove(name_);
+		}
+
+		const std::string& name() const { return name_; }
+
+	private:
+		static int& counter() { static int c = 0; return c; }
+
+		std::string name_;
+	};
+}
+
+TEST(shared_vector_test, offset_ptr)
+{
+	int values[2] = { 1, 2 };
+	offset_ptr<int> p(values), q;
+	ASSERT_FALSE(q);
+	ASSERT_EQ(nullptr, q.get());
+	q = p;
+	ASSERT_TRUE(q == p);
+	ASSERT_EQ(2, q[1]);
+
+	// a copy constructed at another address still points to the same target
+	char storage[sizeof(offset_ptr<int>)];
+	offset_ptr<int>* moved = ::new(storage) offset_ptr<int>(p);
+	ASSERT_EQ(values, moved->get());
+	ASSERT_EQ(1, **moved);
+}
+
+TEST(shared_vector_test, mapped_twice)
+{
+	temp_segment_name name;
+	shared_memory_segment writerSegment(name.name(), shared_vector<std::int64_t>::required_bytes(1000));
+	ASSERT_THROW(shared_memory_segment(name.name(), 4096), std::system_error);
+
+	shared_vector<std::int64_t>* writer = shared_vector<std::int64_t>::create(writerSegment, 1000);
+	writer->push_back(42);
+
+	// a second mapping of the same segment lives at another address
+	shared_memory_segment readerSegment(name.name());
+	ASSERT_NE(writerSegment.data(), readerSegment.data());
+	const shared_vector<std::int64_t>* reader = shared_vector<std::int64_t>::attach(readerSegment);
+	ASSERT_EQ(1000, reader->capacity());
+	ASSERT_EQ(1, reader->size());
+	ASSERT_EQ(42, (*reader)[0]);
+	ASSERT_EQ(static_cast<const char*>(readerSegment.data()) + (reinterpret_cast<const char*>(writer->data()) - static_cast<const char*>(writerSegment.data())),
+		reinterpret_cast<const char*>(reader->data()));
+
+	for(std::int64_t i = 1; i < 1000; ++i)
+		writer->emplace_back(i * 3);
+	ASSERT_THROW(writer->push_back(0), std::length_error);
+	ASSERT_EQ(1000, reader->size());
+	ASSERT_EQ(999 * 3, *(reader->end() - 1));
+
+	writer->clear();
+	ASSERT_TRUE(reader->empty());
+
+	ASSERT_THROW(shared_vector<std::int32_t>::attach(readerSegment), std::runtime_error);
+	ASSERT_THROW(shared_vector<std::int64_t>::create(writerSegment, 1001), std::length_error);
+	ASSERT_THROW(shared_memory_segment(name.name() + "_missing"), std::system_error);
+}
+
+TEST(shared_vector_test, concurrent_reader)
+{
+	temp_segment_name name;
+	const unsigned int count = 100000;
+	shared_memory_segment writerSegment(name.name(), shared_vector<unsigned int>::required_bytes(count));
+	shared_vector<unsigned int>* writer = shared_vector<unsigned int>::create(writerSegment, count);
+
+	shared_memory_segment readerSegment(name.name());
+	const shared_vector<unsigned int>* reader = shared_vector<unsigned int>::attach(readerSegment);
+
+	bool consistent = true;
+	std::thread readerThread([&]
+	{
+		// every published element must be visible through the other mapping
+		std::uint64_t checked = 0;
+		while(checked < count)
+		{
+			const std::uint64_t size = reader->size();
+			for(; checked < size; ++checked)
+				consistent = consistent && (*reader)[checked] == checked * 7;
+		}
+	});
+	for(unsigned int i = 0; i < count; ++i)
+		writer->push_back(i * 7);
+	readerThread.join();
+	ASSERT_TRUE(consistent);
+}
+
+TEST(shared_vector_test, other_process)
+{
+	temp_segment_name name;
+	shared_memory_segment segment(name.name(), shared_vector<int>::required_bytes(500));
+	const shared_vector<int>* v = shared_vector<int>::create(segment, 500);
+
+	const pid_t child = ::fork();
+	ASSERT_NE(-1, child);
+	if(child == 0)
+	{
+		int status = 1;
+		try
+		{
+			shared_memory_segment childSegment(name.name());
+			shared_vector<int>* w = shared_vector<int>::attach(childSegment);
+			for(int i = 0; i < 500; ++i)
+				w->push_back(i - 250);
+			status = 0;
+		}
+		catch(...)
+		{
+		}
+		::_exit(status);
+	}
+
+	int status = 0;
+	ASSERT_EQ(child, ::waitpid(child, &status, 0));
+	ASSERT_TRUE(WIFEXITED(status));
+	ASSERT_EQ(0, WEXITSTATUS(status));
+	ASSERT_EQ(500, v->size());
+	ASSERT_EQ(-250, *v->begin());
+	ASSERT_EQ(249, (*v)[499]);
+}
+
+TEST(huge_page_allocator_test, backing)
+{
+	typedef fixed_capacity_vector<int, huge_page_allocator<int>, std::size_t> vector_type;
+	const std::size_t large = 3 * fcv_detail::huge_page_size() / sizeof(int);
+	ASSERT_EQ(0, fcv_detail::huge_page_size() % fcv_detail::small_page_size());
+
+	vector_type v(large);
+	const page_backing backing = v.get_allocator().backing();
+	if(backing != page_backing::small_pages)
+	{
+		ASSERT_EQ(0, reinterpret_cast<std::uintptr_t>(v.data()) % fcv_detail::huge_page_size());
+	}
+	if(fcv_detail::transparent_huge_pages_enabled())
+	{
+		ASSERT_NE(page_backing::small_pages, backing);
+	}
+	v.resize(large, 3);
+	ASSERT_EQ(3, v[large - 1]);
+	ASSERT_EQ(large * 3, static_cast<std::size_t>(std::accumulate(v.begin(), v.end(), 0)));
+
+	// the allocation follows the container on move and swap
+	vector_type moved(std::move(v));
+	ASSERT_EQ(backing, moved.get_allocator().backing());
+	ASSERT_EQ(3, moved[0]);
+
+	// small allocations and a preference for small pages use ordinary pages
+	vector_type small(100);
+	ASSERT_EQ(page_backing::small_pages, small.get_allocator().backing());
+	small.push_back(1);
+	swap(small, moved);
+	ASSERT_EQ(backing, small.get_allocator().backing());
+	ASSERT_EQ(1, moved[0]);
+
+	vector_type plain(large, huge_page_allocator<int>(page_backing::small_pages));
+	ASSERT_EQ(page_backing::small_pages, plain.get_allocator().backing());
+	plain.assign(small.begin(), small.end());
+	ASSERT_EQ(large, plain.size());
+
+	vector_type empty(0);
+	ASSERT_EQ(0, empty.capacity());
+}
+
+TEST(numa_allocator_test, policies)
+{
+	// without NUMA support in the kernel placement cannot be checked
+	const std::vector<int> allowed = numa_allowed_nodes();
+	if(allowed.empty())
+		return;
+
+	typedef fixed_capacity_vector<int, numa_allocator<int>, std::size_t> vector_type;
+	const numa_policy policies[] = { numa_policy::first_touch, numa_policy::local, numa_policy::interleave, numa_policy::bind };
+	for(numa_policy policy : policies)
+	{
+		vector_type v(1 << 18, numa_allocator<int>(policy, allowed.back()));
+		ASSERT_TRUE(v.get_allocator().placement_applied());
+		numa_policy applied;
+		ASSERT_TRUE(numa_policy_of_address(v.data(), applied));
+		ASSERT_EQ(policy, applied);
+
+		v.resize(v.capacity(), 5);
+		ASSERT_EQ(5, v.back());
+		for(std::size_t i = 0; i < v.size(); i += 4096)
+			ASSERT_NE(allowed.end(), std::find(allowed.begin(), allowed.end(), numa_node_of_address(&v[i])));
+		if(policy == numa_policy::bind)
+		{
+			ASSERT_EQ(allowed.back(), numa_node_of_address(v.data()));
+		}
+	}
+
+	// a node that does not exist leaves the default placement
+	vector_type v(100, numa_allocator<int>(numa_policy::bind, 1023));
+	ASSERT_FALSE(v.get_allocator().placement_applied());
+	v.push_back(1);
+	ASSERT_EQ(1, v[0]);
+}
+
+TEST(numa_allocator_test, first_touch_resize)
+{
+	const std::size_t n = 1000003;
+	fixed_capacity_vector<std::int64_t, numa_allocator<std::int64_t>, std::size_t> v(n);
+	v.push_back(-1);
+	numa_first_touch_resize(v, n, 4, [](std::size_t i) { return static_cast<std::int64_t>(i) * 2; });
+	ASSERT_EQ(n, v.size());
+	ASSERT_EQ(-1, v[0]);
+	for(std::size_t i = 1; i < n; ++i)
+		ASSERT_EQ(static_cast<std::int64_t>(i) * 2, v[i]);
+
+	ASSERT_EQ(std::make_pair(std::size_t(0), std::size_t(4)), numa_chunk(10, 0, 3));
+	ASSERT_EQ(std::make_pair(std::size_t(7), std::size_t(10)), numa_chunk(10, 2, 3));
+	ASSERT_EQ(std::make_pair(std::size_t(2), std::size_t(2)), numa_chunk(2, 3, 4));
+
+	// an exception in any thread restores the previous size, the old elements are not written
+	v.resize(10);
+	ASSERT_THROW(numa_first_touch_resize(v, n, 3, [](std::size_t i) -> std::int64_t
+	{
+		if(i == 700000)
+			throw std::runtime_error("generator failed");
+		return 0;
+	}), std::runtime_error);
+	ASSERT_EQ(10, v.size());
+	ASSERT_EQ(-1, v[0]);
+	ASSERT_EQ(18, v[9]);
+
+	const std::vector<int> allowed = numa_allowed_nodes();
+	if(allowed.empty())
+		return;
+
+	// chunks placed on explicit nodes
+	fixed_capacity_vector<std::int64_t, numa_allocator<std::int64_t>, std::size_t> placed(n);
+	const std::vector<int> nodes = { allowed.front(), allowed.back() };
+	numa_first_touch_resize(placed, n, 2, [](std::size_t i) { return static_cast<std::int64_t>(i); }, nodes);
+	ASSERT_EQ(allowed.front(), numa_node_of_address(&placed[0]));
+	ASSERT_EQ(allowed.back(), numa_node_of_address(&placed[n - 1]));
+	ASSERT_EQ(static_cast<std::int64_t>(n - 1), placed.back());
+}
+
+TEST(parallel_algorithms_test, thread_pool)
+{
+	fcv_parallel::thread_pool pool(4);
+	ASSERT_EQ(4, pool.concurrency());
+
+	std::vector<std::atomic<int>> calls(1000);
+	pool.run(calls.size(), [&](std::size_t i) { ++calls[i]; });
+	ASSERT_TRUE(std::all_of(calls.begin(), calls.end(), [](const std::atomic<int>& c) { return c == 1; }));
+
+	// nested runs execute serially on the calling thread
+	std::atomic<int> nested(0);
+	pool.run(8, [&](std::size_t) { pool.run(8, [&](std::size_t) { ++nested; }); });
+	ASSERT_EQ(64, nested);
+
+	// the remaining tasks still run after one throws
+	std::atomic<int> completed(0);
+	ASSERT_THROW(pool.run(100, [&](std::size_t i)
+	{
+		if(i == 17)
+			throw std::runtime_error("task failed");
+		++completed;
+	}), std::runtime_error);
+	ASSERT_EQ(99, completed);
+
+	fcv_parallel::thread_pool single(1);
+	int sum = 0;
+	single.run(10, [&](std::size_t i) { sum += static_cast<int>(i); });
+	ASSERT_EQ(45, sum);
+}
+
+TEST(parallel_algorithms_test, algorithms)
+{
+	// a small cutoff exercises the parallel paths with few elements
+	fcv_parallel::thread_pool pool(3, 64);
+	const std::size_t n = 100003;
+
+	fixed_capacity_vector<std::int64_t, std::allocator<std::int64_t>, std::size_t> v(n);
+	v.resize(n);
+	fcv_parallel::fill(v.begin(), v.end(), 7, pool);
+	ASSERT_EQ(n, static_cast<std::size_t>(std::count(v.begin(), v.end(), 7)));
+
+	std::iota(v.begin(), v.end(), 0);
+	fcv_parallel::for_each(v.begin(), v.end(), [](std::int64_t& x) { x = x * 3 % 1001; }, pool);
+	ASSERT_EQ(3 * 500 % 1001, v[500]);
+
+	std::vector<std::int64_t> transformed(n);
+	ASSERT_EQ(transformed.end(), fcv_parallel::transform(v.begin(), v.end(), transformed.begin(), [](std::int64_t x) { return -x; }, pool));
+	ASSERT_EQ(-v[n - 1], transformed[n - 1]);
+
+	std::vector<std::int64_t> copied(n);
+	fcv_parallel::copy(v.begin(), v.end(), copied.begin(), pool);
+	ASSERT_TRUE(std::equal(v.begin(), v.end(), copied.begin()));
+
+	ASSERT_EQ(std::accumulate(v.begin(), v.end(), std::int64_t(5)), fcv_parallel::reduce(v.begin(), v.end(), std::int64_t(5), pool));
+	// the chunks are combined in order, so non-commutative operations work
+	std::vector<std::string> words(1000);
+	for(std::size_t i = 0; i < words.size(); ++i)
+		words[i] = std::to_string(i % 10);
+	ASSERT_EQ(std::accumulate(words.begin(), words.end(), std::string(">")),
+		fcv_parallel::reduce(words.begin(), words.end(), std::string(">"), pool));
+
+	fcv_parallel::sort(v.begin(), v.end(), pool);
+	ASSERT_TRUE(std::is_sorted(v.begin(), v.end()));
+	std::sort(copied.begin(), copied.end());
+	ASSERT_TRUE(std::equal(v.begin(), v.end(), copied.begin()));
+	fcv_parallel::sort(v.begin(), v.end(), std::greater<std::int64_t>(), pool);
+	ASSERT_TRUE(std::is_sorted(v.rbegin(), v.rend()));
+
+	// sizes around the chunk boundaries
+	for(std::size_t size : { 0, 1, 63, 64, 65, 1000 })
+	{
+		std::vector<int> small(size);
+		for(std::size_t i = 0; i < size; ++i)
+			small[i] = static_cast<int>((i * 7919) % 101);
+		fcv_parallel::sort(small.begin(), small.end(), pool);
+		ASSERT_TRUE(std::is_sorted(small.begin(), small.end()));
+		ASSERT_EQ(std::accumulate(small.begin(), small.end(), 0), fcv_parallel::reduce(small.begin(), small.end(), 0, pool));
+	}
+}
+
+TEST(parallel_algorithms_test, copy_of)
+{
+	fcv_parallel::thread_pool pool(3, 64);
+
+	fixed_capacity_vector<int> ints(5000);
+	for(int i = 0; i < 4000; ++i)
+		ints.push_back(i);
+	const fixed_capacity_vector<int> intCopy = fcv_parallel::copy_of(ints, pool);
+	ASSERT_EQ(ints.capacity(), intCopy.capacity());
+	ASSERT_EQ(ints.size(), intCopy.size());
+	ASSERT_TRUE(std::equal(ints.begin(), ints.end(), intCopy.begin()));
+
+	fixed_capacity_vector<std::string> strings(3000);
+	for(int i = 0; i < 2000; ++i)
+		strings.push_back(std::string(i % 50, 'x'));
+	const fixed_capacity_vector<std::string> stringCopy = fcv_parallel::copy_of(strings, pool);
+	ASSERT_EQ(strings.size(), stringCopy.size());
+	ASSERT_TRUE(std::equal(strings.begin(), strings.end(), stringCopy.begin()));
+
+	// without a default constructor the elements are copied serially
+	struct no_default
+	{
+		explicit no_default(int v) : value(v) {}
+		int value;
+	};
+	fixed_capacity_vector<no_default> values(100);
+	values.emplace_back(3);
+	const fixed_capacity_vector<no_default> valueCopy = fcv_parallel::copy_of(values, pool);
+	ASSERT_EQ(1, valueCopy.size());
+	ASSERT_EQ(3, valueCopy[0].value);
+}
+
+TEST(serialization_test, raw)
+{
+	temp_file file;
+	const int fd = ::open(file.path().c_str(), O_RDWR);
+	ASSERT_LE(0, fd);
+
+	fixed_capacity_vector<mapped_record> records(50);
+	for(int i = 0; i < 40; ++i)
+	{
+		const mapped_record r = { i, i * 0.25, { 'x', 'y', 'z', 0 } };
+		records.push_back(r);
+	}
+	fixed_capacity_vector<std::int16_t> empty(4);
+	fcv_serialization::write(fd, records);
+	fcv_serialization::write(fd, empty);
+	ASSERT_EQ(2 * sizeof(fcv_serialization::record_header) + 40 * sizeof(mapped_record),
+		static_cast<std::size_t>(::lseek(fd, 0, SEEK_CUR)));
+
+	ASSERT_EQ(0, ::lseek(fd, 0, SEEK_SET));
+	fixed_capacity_vector<mapped_record> read(40);
+	read.resize(3);
+	fcv_serialization::read(fd, read);
+	ASSERT_EQ(40, read.size());
+	ASSERT_EQ(39, read[39].id);
+	ASSERT_EQ(39 * 0.25, read[39].value);
+	fixed_capacity_vector<std::int16_t> readEmpty(1, { 5 });
+	ASSERT_TRUE(fcv_serialization::try_read(fd, readEmpty));
+	ASSERT_TRUE(readEmpty.empty());
+	ASSERT_FALSE(fcv_serialization::try_read(fd, readEmpty));
+	ASSERT_THROW(fcv_serialization::read(fd, readEmpty), std::runtime_error);
+
+	// load() restores the capacity of the written vector
+	ASSERT_EQ(0, ::lseek(fd, 0, SEEK_SET));
+	const fixed_capacity_vector<mapped_record> loaded = fcv_serialization::load<fixed_capacity_vector<mapped_record>>(fd);
+	ASSERT_EQ(50, loaded.capacity());
+	ASSERT_EQ(40, loaded.size());
+	ASSERT_EQ('y', loaded[20].tag[1]);
+
+	// rejected records
+	ASSERT_EQ(0, ::lseek(fd, 0, SEEK_SET));
+	fixed_capacity_vector<mapped_record> small(10);
+	ASSERT_THROW(fcv_serialization::read(fd, small), std::length_error);
+	ASSERT_EQ(0, ::lseek(fd, 0, SEEK_SET));
+	fixed_capacity_vector<std::int64_t> otherType(100);
+	ASSERT_THROW(fcv_serialization::read(fd, otherType), std::runtime_error);
+
+	fcv_serialization::record_header header;
+	ASSERT_EQ(static_cast<::ssize_t>(sizeof(header)), ::pread(fd, &header, sizeof(header), 0));
+	header.byte_order = __builtin_bswap32(header.byte_order);
+	ASSERT_EQ(static_cast<::ssize_t>(sizeof(header)), ::pwrite(fd, &header, sizeof(header), 0));
+	ASSERT_EQ(0, ::lseek(fd, 0, SEEK_SET));
+	ASSERT_THROW(fcv_serialization::read(fd, read), std::runtime_error);
+
+	header.byte_order = __builtin_bswap32(header.byte_order);
+	ASSERT_EQ(static_cast<::ssize_t>(sizeof(header)), ::pwrite(fd, &header, sizeof(header), 0));
+	ASSERT_EQ(0, ::ftruncate(fd, sizeof(header) + 10 * sizeof(mapped_record)));
+	ASSERT_EQ(0, ::lseek(fd, 0, SEEK_SET));
+	ASSERT_THROW(fcv_serialization::read(fd, read), std::runtime_error);
+	::close(fd);
+}
+
+TEST(serialization_test, length_prefixed)
+{
+	temp_file file;
+	const int fd = ::open(file.path().c_str(), O_RDWR);
+	ASSERT_LE(0, fd);
+
+	fixed_capacity_vector<std::string> strings(10, { "first", "", std::string(1000, 'l'), "last" });
+	fixed_capacity_vector<std::vector<char>> bytes(3, { std::vector<char>(3, 'a'), std::vector<char>() });
+	fcv_serialization::write(fd, strings);
+	fcv_serialization::write(fd, bytes);
+	ASSERT_EQ(2 * sizeof(fcv_serialization::record_header) + 6 * sizeof(std::uint64_t) + 1012,
+		static_cast<std::size_t>(::lseek(fd, 0, SEEK_CUR)));
+
+	ASSERT_EQ(0, ::lseek(fd, 0, SEEK_SET));
+	fixed_capacity_vector<std::string> readStrings(4, { "x", "y", "z", "w" });
+	fcv_serialization::read(fd, readStrings);
+	ASSERT_EQ(4, readStrings.size());
+	ASSERT_TRUE(std::equal(strings.begin(), strings.end(), readStrings.begin()));
+	fixed_capacity_vector<std::vector<char>> readBytes(2);
+	fcv_serialization::read(fd, readBytes);
+	ASSERT_EQ(2, readBytes.size());
+	ASSERT_EQ(bytes[0], readBytes[0]);
+	ASSERT_TRUE(readBytes[1].empty());
+
+	// strings are not interchangeable with raw chars
+	ASSERT_EQ(0, ::lseek(fd, 0, SEEK_SET));
+	fixed_capacity_vector<char> chars(100);
+	ASSERT_THROW(fcv_serialization::read(fd, chars), std::runtime_error);
+	::close(fd);
+}
+
+namespace
+{
+	int counted_allocations = 0;
+
+	// stateless allocator counting its allocations in counted_allocations
+	template<typename T>
+	struct counting_allocator
+	{
+		typedef T value_type;
+
+		counting_allocator() {}
+		template<typename U>
+		counting_allocator(const counting_allocator<U>&) {}
+
+		T* allocate(std::size_t n)
+		{
+			++counted_allocations;
+			return std::allocator<T>().allocate(n);
+		}
+		void deallocate(T* p, std::size_t n)
+		{
+			std::allocator<T>().deallocate(p, n);
+		}
+	};
+
+	template<typename T, typename U>
+	bool operator==(const counting_allocator<T>&, const counting_allocator<U>&) { return true; }
+	template<typename T, typename U>
+	bool operator!=(const counting_allocator<T>&, const counting_allocator<U>&) { return false; }
+}
+
+TEST(serialization_test, length_prefixed_allocations)
+{
+	typedef std::basic_string<char, std::char_traits<char>, counting_allocator<char>> counted_string;
+	temp_file file;
+	const int fd = ::open(file.path().c_str(), O_RDWR);
+	ASSERT_LE(0, fd);
+
+	fixed_capacity_vector<std::string> strings(5, { std::string(100, 'a'), "", std::string(200, 'b'), "short", std::string(300, 'c') });
+	fcv_serialization::write(fd, strings);
+	strings[2].resize(150);
+	fcv_serialization::write(fd, strings);
+
+	// fresh elements allocate for every string longer than the small string buffer
+	ASSERT_EQ(0, ::lseek(fd, 0, SEEK_SET));
+	counted_allocations = 0;
+	fixed_capacity_vector<counted_string> loaded = fcv_serialization::load<fixed_capacity_vector<counted_string>>(fd);
+	ASSERT_EQ(3, counted_allocations);
+	ASSERT_EQ(300, loaded[4].size());
+
+	// reloading into the same elements reuses their buffers
+	counted_allocations = 0;
+	ASSERT_TRUE(fcv_serialization::try_read(fd, loaded));
+	ASSERT_EQ(0, counted_allocations);
+	ASSERT_EQ(150, loaded[2].size());
+	ASSERT_EQ("short", loaded[3]);
+	::close(fd);
+}
+
+TEST(serialization_test, stream_writer)
+{
+	int fds[2];
+	ASSERT_EQ(0, ::pipe(fds));
+
+	const int count = 10000;
+	std::thread writer([&]
+	{
+		fcv_serialization::stream_writer<std::string> stream(fds[1], 64);
+		for(int i = 0; i < count; ++i)
+			stream.push(std::to_string(i));
+		ASSERT_EQ(count % 64, stream.buffered());
+	});
+
+	fixed_capacity_vector<std::string> batch(64);
+	int next = 0, records = 0;
+	bool ordered = true;
+	while(next < count && fcv_serialization::try_read(fds[0], batch))
+	{
+		++records;
+		for(const std::string& s : batch)
+			ordered = ordered && s == std::to_string(next++);
+	}
+	writer.join();
+	::close(fds[1]);
+	ASSERT_FALSE(fcv_serialization::try_read(fds[0], batch));
+	::close(fds[0]);
+
+	ASSERT_TRUE(ordered);
+	ASSERT_EQ(count, next);
+	ASSERT_EQ((count + 63) / 64, records);
+}
+
+TEST(fd_io_test, read_from)
+{
+	int fds[2];
+	ASSERT_EQ(0, ::pipe(fds));
+	const std::string message = "0123456789abcdefghij";
+	ASSERT_EQ(static_cast<::ssize_t>(message.size()), ::write(fds[1], message.data(), message.size()));
+
+	fixed_capacity_vector<char> v(16, { '>' });
+	fcv_io::io_result result = fcv_io::read_from(fds[0], v);
+	ASSERT_EQ(fcv_io::io_status::ok, result.status);
+	ASSERT_EQ(15, result.bytes);
+	ASSERT_EQ(16, v.size());
+	ASSERT_EQ(">0123456789abcde", std::string(v.begin(), v.end()));
+	ASSERT_EQ(fcv_io::io_status::full, fcv_io::read_from(fds[0], v).status);
+
+	// the consumed front is erased to make room again
+	v.erase(v.begin(), v.begin() + 11);
+	result = fcv_io::read_from(fds[0], v);
+	ASSERT_EQ(5, result.bytes);
+	ASSERT_EQ("abcdefghij", std::string(v.begin(), v.end()));
+
+	ASSERT_EQ(0, ::fcntl(fds[0], F_SETFL, ::fcntl(fds[0], F_GETFL) | O_NONBLOCK));
+	result = fcv_io::read_from(fds[0], v);
+	ASSERT_EQ(fcv_io::io_status::would_block, result.status);
+	ASSERT_EQ(10, v.size());
+
+	::close(fds[1]);
+	result = fcv_io::read_from(fds[0], v);
+	ASSERT_EQ(fcv_io::io_status::end_of_file, result.status);
+	ASSERT_EQ(0, result.bytes);
+	ASSERT_EQ(10, v.size());
+
+	// errors keep the previous contents
+	ASSERT_THROW(fcv_io::read_from(-1, v), std::system_error);
+	ASSERT_EQ("abcdefghij", std::string(v.begin(), v.end()));
+	::close(fds[0]);
+}
+
+TEST(fd_io_test, read_from_several)
+{
+	int fds[2];
+	ASSERT_EQ(0, ::pipe(fds));
+	const std::string message = "headerpayload-and-more";
+	ASSERT_EQ(static_cast<::ssize_t>(message.size()), ::write(fds[1], message.data(), message.size()));
+
+	fixed_capacity_vector<std::uint8_t> full(2, { 1, 2 }), header(6), payload(12);
+	fcv_io::io_result result = fcv_io::read_from(fds[0], { &full, &header, &payload });
+	ASSERT_EQ(fcv_io::io_status::ok, result.status);
+	ASSERT_EQ(18, result.bytes);
+	ASSERT_EQ(2, full.size());
+	ASSERT_EQ("header", std::string(header.begin(), header.end()));
+	ASSERT_EQ("payload-and-", std::string(payload.begin(), payload.end()));
+
+	ASSERT_EQ(fcv_io::io_status::full, fcv_io::read_from(fds[0], { &full, &header, &payload }).status);
+	payload.clear();
+	result = fcv_io::read_from(fds[0], { &header, &payload });
+	ASSERT_EQ(4, result.bytes);
+	ASSERT_EQ("more", std::string(payload.begin(), payload.end()));
+
+	::close(fds[1]);
+	ASSERT_EQ(fcv_io::io_status::end_of_file, fcv_io::read_from(fds[0], { &header, &payload }).status);
+	ASSERT_THROW(fcv_io::read_from(-1, { &payload }), std::system_error);
+	ASSERT_EQ(4, payload.size());
+	::close(fds[0]);
+}
+
+TEST(fd_io_test, write_to)
+{
+	int fds[2];
+	ASSERT_EQ(0, ::pipe(fds));
+	ASSERT_EQ(0, ::fcntl(fds[1], F_SETFL, ::fcntl(fds[1], F_GETFL) | O_NONBLOCK));
+
+	// more than a pipe holds, so writes stop part way
+	const std::size_t n = 1 << 20;
+	fixed_capacity_vector<char> out(n);
+	for(std::size_t i = 0; i < n; ++i)
+		out.push_back(static_cast<char>('a' + i % 26));
+
+	std::size_t offset = 0;
+	fcv_io::io_result result = fcv_io::write_to(fds[1], out, offset);
+	ASSERT_EQ(fcv_io::io_status::ok, result.status);
+	ASSERT_LT(0, result.bytes);
+	ASSERT_GT(n, offset);
+	ASSERT_EQ(offset, result.bytes);
+	ASSERT_EQ(fcv_io::io_status::would_block, fcv_io::write_to(fds[1], out, offset).status);
+
+	// drain through the other end until the cursor reaches the end
+	fixed_capacity_vector<char> in(n);
+	while(offset < n)
+	{
+		fcv_io::read_from(fds[0], in);
+		fcv_io::write_to(fds[1], out, offset);
+	}
+	::close(fds[1]);
+	while(fcv_io::read_from(fds[0], in).status == fcv_io::io_status::ok)
+		;
+	ASSERT_EQ(n, in.size());
+	ASSERT_TRUE(std::equal(out.begin(), out.end(), in.begin()));
+
+	result = fcv_io::write_to(fds[1], out, offset);
+	ASSERT_EQ(0, result.bytes);
+	ASSERT_EQ(n, offset);
+	::close(fds[0]);
+}
+
 int main(int argc, char* argv[])
 {
 	::testing::InitGoogleTest(&argc, argv);
@@ -0,0 +1,345 @@
+
+#pragma once
+
+#include "posix_io.h"
+#include "vector.h"
+#include <cstdint>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+enum class mapped_file_mode
+{
+	create,		// create or truncate the file, then map it read-write
+	read_only,
+	read_write
+};
+
+// Header at the start of every mapped file. The elements follow at offset
+// data_offset, which keeps them aligned to a cache line within the page aligned
+// mapping. size is only as recent as the last sync() of the owner.
+struct mapped_file_header
+{
+	std::uint64_t magic;
+	std::uint32_t version;
+	std::uint32_t element_size;
+	std::uint64_t capacity;
+	std::uint64_t size;
+
+	enum : std::uint64_t { expected_magic = 0x3130504d56434631ull };	// "1FCVMP01" read little endian
+	enum : std::uint32_t { current_version = 1 };
+	enum : std::size_t { data_offset = 64 };
+};
+
+
+// A file holding a mapped_file_header and room for capacity elements of
+// element_size bytes, mapped into memory as a whole with MAP_SHARED. Opening an
+// existing file only validates the header, no element is read or copied.
+class mapped_file
+{
+public:
+	mapped_file(const std::string& path, mapped_file_mode mode, std::size_t elementSize, std::size_t capacity = 0)
+		: fd_(-1), mapping_(nullptr), length_(0), writable_(mode != mapped_file_mode::read_only), claimed_(false)
+	{
+		fd_ = ::open(path.c_str(), mode == mapped_file_mode::create ? O_RDWR | O_CREAT | O_TRUNC
+			: (writable_ ? O_RDWR : O_RDONLY), 0644);
+		if(fd_ < 0)
+			fcv_detail::throw_errno("cannot open " + path);
+
+		try
+		{
+			if(mode == mapped_file_mode::create)
+				_create(elementSize, capacity);
+			else
+				_open(elementSize, path);
+		}
+		catch(...)
+		{
+			_close();
+			throw;
+		}
+	}
+
+	mapped_file(const mapped_file&) = delete;
+	mapped_file& operator=(const mapped_file&) = delete;
+
+	~mapped_file() FCV_NOEXCEPT
+	{
+		_close();
+	}
+
+	bool writable() const FCV_NOEXCEPT
+	{
+		return writable_;
+	}
+
+	// number of elements the file has room for
+	std::size_t capacity() const FCV_NOEXCEPT
+	{
+		return static_cast<std::size_t>(_header().capacity);
+	}
+
+	// number of elements recorded by the last sync
+	std::size_t stored_size() const FCV_NOEXCEPT
+	{
+		return static_cast<std::size_t>(_header().size);
+	}
+
+	std::size_t element_size() const FCV_NOEXCEPT
+	{
+		return _header().element_size;
+	}
+
+	void* data() const FCV_NOEXCEPT
+	{
+		return static_cast<char*>(mapping_) + mapped_file_header::data_offset;
+	}
+
+	// records size in the header and flushes the mapping to the file
+	void sync(std::size_t size)
+	{
+		assert(writable_ && "sync() called on read-only mapped_file");
+		assert(size <= capacity());
+		static_cast<mapped_file_header*>(mapping_)->size = size;
+		if(::msync(mapping_, length_, MS_SYNC) != 0)
+			fcv_detail::throw_errno("msync failed");
+	}
+
+	// the data can be handed to one container at a time
+	bool claim() FCV_NOEXCEPT
+	{
+		if(claimed_)
+			return false;
+		claimed_ = true;
+		return true;
+	}
+
+	void unclaim() FCV_NOEXCEPT
+	{
+		claimed_ = false;
+	}
+
+private:
+	const mapped_file_header& _header() const FCV_NOEXCEPT
+	{
+		return *static_cast<const mapped_file_header*>(mapping_);
+	}
+
+	void _map(std::size_t length)
+	{
+		void* p = ::mmap(nullptr, length, writable_ ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd_, 0);
+		if(p == MAP_FAILED)
+			fcv_detail::throw_errno("mmap failed");
+		mapping_ = p;
+		length_ = length;
+	}
+
+	void _create(std::size_t elementSize, std::size_t capacity)
+	{
+		if(capacity > (static_cast<std::size_t>(-1) - mapped_file_header::data_offset) / elementSize)
+			throw std::length_error("capacity of mapped_file too large");
+
+		const std::size_t length = mapped_file_header::data_offset + capacity * elementSize;
+		if(::ftruncate(fd_, static_cast<off_t>(length)) != 0)
+			fcv_detail::throw_errno("ftruncate failed");
+		_map(length);
+
+		mapped_file_header* header = static_cast<mapped_file_header*>(mapping_);
+		header->magic = mapped_file_header::expected_magic;
+		header->version = mapped_file_header::current_version;
+		header->element_size = static_cast<std::uint32_t>(elementSize);
+		header->capacity = capacity;
+		header->size = 0;
+	}
+
+	void _open(std::size_t elementSize, const std::string& path)
+	{
+		struct stat st;
+		if(::fstat(fd_, &st) != 0)
+			fcv_detail::throw_errno("fstat failed");
+		const std::size_t length = static_cast<std::size_t>(st.st_size);
+		if(length < mapped_file_header::data_offset)
+			throw std::runtime_error(path + " is too small to be a mapped_file");
+		_map(length);
+
+		const mapped_file_header& header = _header();
+		if(header.magic != mapped_file_header::expected_magic || header.version != mapped_file_header::current_version)
+			throw std::runtime_error(path + " is not a mapped_file of a supported version");
+		if(header.element_size != elementSize)
+			throw std::runtime_error(path + " holds elements of a different size");
+		if(header.size > header.capacity
+			|| header.capacity > (length - mapped_file_header::data_offset) / elementSize)
+			throw std::runtime_error(path + " is truncated or its header is corrupt");
+	}
+
+	void _close() FCV_NOEXCEPT
+	{
+		if(mapping_)
+			::munmap(mapping_, length_);
+		if(fd_ >= 0)
+			::close(fd_);
+		mapping_ = nullptr;
+		fd_ = -1;
+	}
+
+private:
+	int fd_;
+	void* mapping_;
+	std::size_t length_;
+	bool writable_;
+	bool claimed_;
+};
+
+
+// Allocator handing out the element area of a mapped_file. The area can back a
+// single container at a time, a second allocation (e.g. from copying the
+// container) throws std::bad_alloc. Deallocation releases the claim but leaves
+// the data in the file.
+template<
+	typename T
+>
+class mapped_file_allocator
+{
+public:
+	typedef T value_type;
+	typedef std::false_type propagate_on_container_copy_assignment;
+	typedef std::true_type propagate_on_container_move_assignment;
+	typedef std::true_type propagate_on_container_swap;
+
+	template<typename U>
+	struct rebind { typedef mapped_file_allocator<U> other; };
+
+	explicit mapped_file_allocator(mapped_file& file) FCV_NOEXCEPT
+		: file_(&file)
+	{
+	}
+
+	template<typename U>
+	mapped_file_allocator(const mapped_file_allocator<U>& other) FCV_NOEXCEPT
+		: file_(other.file_)
+	{
+	}
+
+	value_type* allocate(std::size_t n)
+	{
+		if(n > file_->capacity() || sizeof(value_type) != file_->element_size() || !file_->claim())
+			throw std::bad_alloc();
+		return static_cast<value_type*>(file_->data());
+	}
+
+	void deallocate(value_type*, std::size_t) FCV_NOEXCEPT
+	{
+		file_->unclaim();
+	}
+
+	mapped_file& file() const FCV_NOEXCEPT
+	{
+		return *file_;
+	}
+
+private:
+	template<typename U>
+	friend class mapped_file_allocator;
+
+	mapped_file* file_;
+};
+
+
+template<typename T, typename U>
+bool operator==(const mapped_file_allocator<T>& lhs, const mapped_file_allocator<U>& rhs)
+{
+	return &lhs.file() == &rhs.file();
+}
+template<typename T, typename U>
+bool operator!=(const mapped_file_allocator<T>& lhs, const mapped_file_allocator<U>& rhs)
+{
+	return !operator==(lhs, rhs);
+}
+
+
+// fixed_capacity_vector whose buffer is the element area of a mapped file. The
+// capacity is fixed when the file is created; opening it again restores the
+// elements recorded by the last sync() in O(1), as they are neither read nor
+// constructed. The destructor of a writable mapped_vector syncs the size.
+// Elements must be trivially copyable and trivially default constructible so
+// that their bytes in the file are valid objects. A read-only mapped_vector
+// must only be accessed through get() const.
+template<
+	typename T
+>
+class mapped_vector
+{
+	static_assert(std::is_trivially_copyable<T>::value && std::is_trivially_default_constructible<T>::value,
+		"mapped_vector requires trivially copyable and trivially default constructible elements");
+	static_assert(std::alignment_of<T>::value <= mapped_file_header::data_offset,
+		"alignment of mapped_vector elements exceeds the alignment of the data in the file");
+
+public:
+	typedef fixed_capacity_vector<T, mapped_file_allocator<T>, std::size_t> container_type;
+
+	// creates or truncates the file at path with room for capacity elements
+	mapped_vector(const std::string& path, std::size_t capacity)
+		: file_(path, mapped_file_mode::create, sizeof(T), capacity)
+		, vector_(capacity, mapped_file_allocator<T>(file_))
+	{
+		file_.sync(0);
+	}
+
+	// maps an existing file read-only or read-write
+	mapped_vector(const std::string& path, mapped_file_mode mode)
+		: file_(path, mode, sizeof(T))
+		, vector_(file_.capacity(), mapped_file_allocator<T>(file_))
+	{
+		assert(mode != mapped_file_mode::create && "use the capacity constructor to create a file");
+		// the elements already are in the buffer, only the size has to be restored
+		vector_.resize_default_init(file_.stored_size());
+	}
+
+	mapped_vector(const mapped_vector&) = delete;
+	mapped_vector& operator=(const mapped_vector&) = delete;
+
+	~mapped_vector() FCV_NOEXCEPT
+	{
+		if(file_.writable())
+		{
+			try
+			{
+				sync();
+			}
+			catch(...)
+			{
+			}
+		}
+	}
+
+	container_type& get() FCV_NOEXCEPT
+	{
+		assert(file_.writable() && "mutable access to a read-only mapped_vector");
+		return vector_;
+	}
+
+	const container_type& get() const FCV_NOEXCEPT
+	{
+		return vector_;
+	}
+
+	bool writable() const FCV_NOEXCEPT
+	{
+		return file_.writable();
+	}
+
+	// stores the current size in the file header and flushes the mapping
+	void sync()
+	{
+		file_.sync(vector_.size());
+	}
+
+private:
+	mapped_file file_;
+	container_type vector_;
+};
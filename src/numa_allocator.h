@@ -0,0 +1,338 @@
+
+#pragma once
+
+#include "vector.h"
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// Placement of the pages of an allocation on the NUMA nodes of the machine.
+enum class numa_policy
+{
+	first_touch,	// kernel default: each page lands on the node of the thread that first writes it
+	local,			// preferably the node of the thread that allocates
+	interleave,		// round robin over all nodes the process may use
+	bind			// only the given node
+};
+
+namespace fcv_detail
+{
+	// the memory policy system calls are used directly, so libnuma is not needed
+	enum
+	{
+		mpol_default = 0,
+		mpol_preferred = 1,
+		mpol_bind = 2,
+		mpol_interleave = 3,
+		mpol_f_addr = 2,
+		mpol_f_mems_allowed = 4
+	};
+
+	struct numa_node_mask
+	{
+		enum : unsigned long { max_nodes = 1024, bits_per_word = sizeof(unsigned long) * 8 };
+
+		numa_node_mask() FCV_NOEXCEPT
+			: words()
+		{
+		}
+
+		void set(int node) FCV_NOEXCEPT
+		{
+			assert(node >= 0 && node < static_cast<int>(max_nodes));
+			words[node / bits_per_word] |= 1ul << (node % bits_per_word);
+		}
+
+		bool test(int node) const FCV_NOEXCEPT
+		{
+			return (words[node / bits_per_word] >> (node % bits_per_word)) & 1;
+		}
+
+		unsigned long words[max_nodes / bits_per_word];
+	};
+
+	inline bool numa_mbind(void* p, std::size_t length, int mode, const numa_node_mask& nodes) FCV_NOEXCEPT
+	{
+		return ::syscall(SYS_mbind, p, length, mode, nodes.words, numa_node_mask::max_nodes, 0) == 0;
+	}
+
+	inline bool numa_set_thread_policy(int mode, const numa_node_mask& nodes) FCV_NOEXCEPT
+	{
+		return ::syscall(SYS_set_mempolicy, mode, nodes.words, numa_node_mask::max_nodes) == 0;
+	}
+
+	inline std::size_t numa_page_size() FCV_NOEXCEPT
+	{
+		static const long size = ::sysconf(_SC_PAGESIZE);
+		return size > 0 ? static_cast<std::size_t>(size) : 4096;
+	}
+}
+
+// node the calling thread currently runs on, -1 if unknown
+inline int numa_current_node() FCV_NOEXCEPT
+{
+	unsigned int cpu = 0, node = 0;
+	return ::syscall(SYS_getcpu, &cpu, &node, nullptr) == 0 ? static_cast<int>(node) : -1;
+}
+
+// nodes the calling thread may allocate memory on, empty if unknown
+inline std::vector<int> numa_allowed_nodes()
+{
+	fcv_detail::numa_node_mask mask;
+	std::vector<int> nodes;
+	if(::syscall(SYS_get_mempolicy, nullptr, mask.words, fcv_detail::numa_node_mask::max_nodes,
+		nullptr, fcv_detail::mpol_f_mems_allowed) == 0)
+	{
+		for(int node = 0; node < static_cast<int>(fcv_detail::numa_node_mask::max_nodes); ++node)
+			if(mask.test(node))
+				nodes.push_back(node);
+	}
+	return nodes;
+}
+
+// node holding the page at p, -1 if unknown or if the page was never touched
+inline int numa_node_of_address(const void* p) FCV_NOEXCEPT
+{
+	const void* pages[1] = { p };
+	int status[1] = { -1 };
+	if(::syscall(SYS_move_pages, 0, 1, pages, nullptr, status, 0) != 0)
+		return -1;
+	return status[0] >= 0 ? status[0] : -1;
+}
+
+// policy the kernel applies to the memory at p, false if it cannot be queried
+inline bool numa_policy_of_address(const void* p, numa_policy& policy) FCV_NOEXCEPT
+{
+	int mode = -1;
+	if(::syscall(SYS_get_mempolicy, &mode, nullptr, 0, p, fcv_detail::mpol_f_addr) != 0)
+		return false;
+
+	switch(mode)
+	{
+	case fcv_detail::mpol_default: policy = numa_policy::first_touch; return true;
+	case fcv_detail::mpol_preferred: policy = numa_policy::local; return true;
+	case fcv_detail::mpol_interleave: policy = numa_policy::interleave; return true;
+	case fcv_detail::mpol_bind: policy = numa_policy::bind; return true;
+	default: return false;
+	}
+}
+
+
+// Allocator mapping page aligned memory with mmap and applying a numa_policy to it
+// with mbind. The policy only decides where pages are placed when they are first
+// written, so it has to be set before the elements are constructed. Placement is
+// an optimization: if the kernel rejects the policy (no NUMA support, a node that
+// does not exist) the allocation still succeeds with the default policy and
+// placement_applied() returns false for it. local prefers the node of the thread
+// calling allocate(), i.e. the one constructing the container.
+template<
+	typename T
+>
+class numa_allocator
+{
+public:
+	typedef T value_type;
+	typedef std::true_type propagate_on_container_move_assignment;
+	typedef std::true_type propagate_on_container_swap;
+	typedef std::true_type is_always_equal;
+
+	template<typename U>
+	struct rebind { typedef numa_allocator<U> other; };
+
+	// node is only used by numa_policy::bind
+	explicit numa_allocator(numa_policy policy = numa_policy::first_touch, int node = 0) FCV_NOEXCEPT
+		: policy_(policy), node_(node), applied_(false)
+	{
+	}
+
+	template<typename U>
+	numa_allocator(const numa_allocator<U>& other) FCV_NOEXCEPT
+		: policy_(other.policy()), node_(other.node()), applied_(false)
+	{
+	}
+
+	value_type* allocate(std::size_t n)
+	{
+		if(n > (static_cast<std::size_t>(-1) - fcv_detail::numa_page_size()) / sizeof(value_type))
+			throw std::bad_alloc();
+
+		const std::size_t length = _mapping_length(n);
+		void* p = ::mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if(p == MAP_FAILED)
+			throw std::bad_alloc();
+
+		applied_ = _apply_policy(p, length);
+		return static_cast<value_type*>(p);
+	}
+
+	void deallocate(value_type* p, std::size_t n) FCV_NOEXCEPT
+	{
+		::munmap(p, _mapping_length(n));
+	}
+
+	numa_policy policy() const FCV_NOEXCEPT
+	{
+		return policy_;
+	}
+
+	int node() const FCV_NOEXCEPT
+	{
+		return node_;
+	}
+
+	// whether the kernel accepted the policy for the last allocation
+	bool placement_applied() const FCV_NOEXCEPT
+	{
+		return applied_;
+	}
+
+private:
+	static std::size_t _mapping_length(std::size_t n) FCV_NOEXCEPT
+	{
+		const std::size_t page = fcv_detail::numa_page_size();
+		const std::size_t bytes = n ? n * sizeof(value_type) : 1;
+		return (bytes + page - 1) / page * page;
+	}
+
+	bool _apply_policy(void* p, std::size_t length) const
+	{
+		fcv_detail::numa_node_mask nodes;
+		switch(policy_)
+		{
+		case numa_policy::first_touch:
+			return fcv_detail::numa_mbind(p, length, fcv_detail::mpol_default, nodes);
+
+		case numa_policy::local:
+		{
+			const int node = numa_current_node();
+			if(node < 0)
+				return false;
+			nodes.set(node);
+			return fcv_detail::numa_mbind(p, length, fcv_detail::mpol_preferred, nodes);
+		}
+
+		case numa_policy::interleave:
+		{
+			const std::vector<int> allowed = numa_allowed_nodes();
+			if(allowed.empty())
+				return false;
+			for(int node : allowed)
+				nodes.set(node);
+			return fcv_detail::numa_mbind(p, length, fcv_detail::mpol_interleave, nodes);
+		}
+
+		case numa_policy::bind:
+			if(node_ < 0 || node_ >= static_cast<int>(fcv_detail::numa_node_mask::max_nodes))
+				return false;
+			nodes.set(node_);
+			return fcv_detail::numa_mbind(p, length, fcv_detail::mpol_bind, nodes);
+		}
+		return false;
+	}
+
+private:
+	numa_policy policy_;
+	int node_;
+	bool applied_;
+};
+
+
+template<typename T, typename U>
+bool operator==(const numa_allocator<T>&, const numa_allocator<U>&)
+{
+	return true;
+}
+template<typename T, typename U>
+bool operator!=(const numa_allocator<T>&, const numa_allocator<U>&)
+{
+	return false;
+}
+
+
+// [first, last) of chunk index when n elements are split into chunks parts whose
+// sizes differ by at most one, the partition used by numa_first_touch_resize()
+inline std::pair<std::size_t, std::size_t> numa_chunk(std::size_t n, std::size_t index, std::size_t chunks) FCV_NOEXCEPT
+{
+	return std::make_pair(n / chunks * index + std::min(index, n % chunks),
+		n / chunks * (index + 1) + std::min(index + 1, n % chunks));
+}
+
+// Resizes v to n elements, element i of the new ones being generate(i), written
+// by one thread per chunk of numa_chunk(n, chunk, chunks). Every new page is first
+// touched by the thread writing its chunk instead of by the caller, so under the
+// first_touch policy each chunk lands on the node of its thread. If nodes is not
+// empty, it names the node for every chunk and the thread writing the chunk
+// prefers it for its page faults, which makes placement independent of where the
+// scheduler runs the threads: workers that later process chunk i on node nodes[i]
+// then only read local memory. Elements already in v are kept and not passed to
+// generate; if generate throws, v keeps its previous size and elements. Elements
+// must be trivial, because resize_default_init() leaves the new elements
+// untouched only for those.
+template<
+	typename _Vector,
+	typename _Generator
+>
+void numa_first_touch_resize(_Vector& v, typename _Vector::size_type n, std::size_t chunks,
+	_Generator generate, const std::vector<int>& nodes = std::vector<int>())
+{
+	typedef typename _Vector::value_type value_type;
+	static_assert(std::is_trivially_default_constructible<value_type>::value && std::is_trivially_copyable<value_type>::value,
+		"numa_first_touch_resize() requires trivial elements");
+	assert(chunks > 0 && "numa_first_touch_resize() needs at least one chunk");
+	assert((nodes.empty() || nodes.size() == chunks) && "numa_first_touch_resize() needs one node per chunk");
+
+	const std::size_t oldSize = v.size();
+	v.resize_and_overwrite(n, [&](value_type* data, typename _Vector::size_type size)
+	{
+		std::vector<std::exception_ptr> errors(chunks);
+		std::vector<std::thread> threads;
+		threads.reserve(chunks);
+		try
+		{
+			for(std::size_t chunk = 0; chunk < chunks; ++chunk)
+			{
+				threads.emplace_back([&, chunk]
+				{
+					try
+					{
+						if(!nodes.empty())
+						{
+							fcv_detail::numa_node_mask mask;
+							mask.set(nodes[chunk]);
+							fcv_detail::numa_set_thread_policy(fcv_detail::mpol_preferred, mask);
+						}
+						// chunks split the full size, so they do not move with the old size
+						const std::pair<std::size_t, std::size_t> range = numa_chunk(size, chunk, chunks);
+						for(std::size_t i = std::max(range.first, oldSize); i < range.second; ++i)
+							data[i] = generate(i);
+					}
+					catch(...)
+					{
+						errors[chunk] = std::current_exception();
+					}
+				});
+			}
+		}
+		catch(...)
+		{
+			// a thread that could not be started: destroying joinable threads terminates
+			for(std::thread& thread : threads)
+				thread.join();
+			throw;
+		}
+		for(std::thread& thread : threads)
+			thread.join();
+		for(const std::exception_ptr& error : errors)
+			if(error)
+				std::rethrow_exception(error);
+		return size;
+	});
+}
@@ -0,0 +1,429 @@
+
+#pragma once
+
+#include "vector.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <numeric>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace fcv_parallel
+{
+	// Fixed set of worker threads executing the chunks of one parallel algorithm at
+	// a time. The calling thread works on the chunks as well, so concurrency() is
+	// the number of workers plus one. Chunks are handed out through a shared
+	// counter, so threads finishing early take over the remaining chunks. Ranges
+	// shorter than serial_cutoff() elements are processed by the caller alone.
+	class thread_pool
+	{
+	public:
+		enum : std::size_t { default_serial_cutoff = 1 << 15 };
+
+		// concurrency 0 uses one thread per hardware thread
+		explicit thread_pool(unsigned int concurrency = 0, std::size_t serialCutoff = default_serial_cutoff)
+			: serialCutoff_(serialCutoff), job_(nullptr), generation_(0), stop_(false)
+		{
+			if(!concurrency)
+				concurrency = std::max(1u, std::thread::hardware_concurrency());
+			workers_.reserve(concurrency - 1);
+			try
+			{
+				for(unsigned int i = 1; i < concurrency; ++i)
+					workers_.emplace_back([this] { _worker(); });
+			}
+			catch(...)
+			{
+				// the destructor does not run, stop the workers already started
+				_stop();
+				throw;
+			}
+		}
+
+		thread_pool(const thread_pool&) = delete;
+		thread_pool& operator=(const thread_pool&) = delete;
+
+		~thread_pool() FCV_NOEXCEPT
+		{
+			_stop();
+		}
+
+		// pool used by the algorithms if none is passed
+		static thread_pool& default_pool()
+		{
+			static thread_pool pool;
+			return pool;
+		}
+
+		std::size_t concurrency() const FCV_NOEXCEPT
+		{
+			return workers_.size() + 1;
+		}
+
+		std::size_t serial_cutoff() const FCV_NOEXCEPT
+		{
+			return serialCutoff_;
+		}
+
+		// calls task(i) for every i in [0, tasks) and returns when all calls have
+		// returned. The first exception thrown by a task is rethrown here, the
+		// remaining tasks still run. Calls from within a task run serially.
+		template<
+			typename _Task
+		>
+		void run(std::size_t tasks, _Task task)
+		{
+			if(workers_.empty() || tasks < 2 || _in_task())
+			{
+				for(std::size_t i = 0; i < tasks; ++i)
+					task(i);
+				return;
+			}
+
+			std::lock_guard<std::mutex> runLock(runMutex_);
+			job j(tasks, task);
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				job_ = &j;
+				++generation_;
+			}
+			wake_.notify_all();
+
+			_work(j);
+			{
+				// all tasks are taken, wait for the workers still executing one
+				std::unique_lock<std::mutex> lock(mutex_);
+				job_ = nullptr;
+				finished_.wait(lock, [&] { return j.participants == 0; });
+			}
+			if(j.error)
+				std::rethrow_exception(j.error);
+		}
+
+	private:
+		struct job
+		{
+			job(std::size_t tasks, std::function<void(std::size_t)> function)
+				: task(std::move(function)), count(tasks), next(0), participants(0)
+			{
+			}
+
+			std::function<void(std::size_t)> task;
+			std::size_t count;
+			std::atomic<std::size_t> next;
+			std::size_t participants;	// guarded by mutex_
+			std::exception_ptr error;	// guarded by mutex_
+		};
+
+		static bool& _in_task() FCV_NOEXCEPT
+		{
+			static thread_local bool inTask = false;
+			return inTask;
+		}
+
+		void _work(job& j)
+		{
+			_in_task() = true;
+			for(std::size_t i = j.next.fetch_add(1); i < j.count; i = j.next.fetch_add(1))
+			{
+				try
+				{
+					j.task(i);
+				}
+				catch(...)
+				{
+					std::lock_guard<std::mutex> lock(mutex_);
+					if(!j.error)
+						j.error = std::current_exception();
+				}
+			}
+			_in_task() = false;
+		}
+
+		void _stop() FCV_NOEXCEPT
+		{
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				stop_ = true;
+			}
+			wake_.notify_all();
+			for(std::thread& worker : workers_)
+				worker.join();
+		}
+
+		void _worker()
+		{
+			std::size_t seen = 0;
+			std::unique_lock<std::mutex> lock(mutex_);
+			for(;;)
+			{
+				wake_.wait(lock, [&] { return stop_ || (job_ && generation_ != seen); });
+				if(stop_)
+					return;
+
+				seen = generation_;
+				job* j = job_;
+				++j->participants;
+				lock.unlock();
+				_work(*j);
+				lock.lock();
+				if(--j->participants == 0)
+					finished_.notify_all();
+			}
+		}
+
+	private:
+		std::size_t serialCutoff_;
+		std::vector<std::thread> workers_;
+		std::mutex runMutex_;
+		std::mutex mutex_;
+		std::condition_variable wake_;
+		std::condition_variable finished_;
+		job* job_;
+		std::size_t generation_;
+		bool stop_;
+	};
+
+	namespace detail
+	{
+		template<typename _RandomIt>
+		struct is_random_access : std::is_base_of<std::random_access_iterator_tag,
+			typename std::iterator_traits<_RandomIt>::iterator_category>
+		{
+		};
+
+		// Splits [0, n) into chunks of whole cache lines, about four per thread so
+		// that uneven chunks balance out, and calls op(first, last) for each of them
+		// through the pool. Serial below the cutoff of the pool.
+		template<
+			typename _Ty,
+			typename _Op
+		>
+		void for_chunks(thread_pool& pool, std::size_t n, _Op op)
+		{
+			if(n < pool.serial_cutoff() || pool.concurrency() == 1)
+			{
+				if(n)
+					op(std::size_t(0), n);
+				return;
+			}
+
+			const std::size_t line = sizeof(_Ty) < 64 && 64 % sizeof(_Ty) == 0 ? 64 / sizeof(_Ty) : 1;
+			std::size_t chunk = std::max<std::size_t>(n / (pool.concurrency() * 4), pool.serial_cutoff() / 4);
+			chunk = (chunk + line - 1) / line * line;
+			const std::size_t chunks = (n + chunk - 1) / chunk;
+			pool.run(chunks, [&](std::size_t i)
+			{
+				op(i * chunk, std::min(n, (i + 1) * chunk));
+			});
+		}
+	}
+
+	template<
+		typename _RandomIt,
+		typename _Ty
+	>
+	void fill(_RandomIt first, _RandomIt last, const _Ty& value, thread_pool& pool = thread_pool::default_pool())
+	{
+		static_assert(detail::is_random_access<_RandomIt>::value, "parallel algorithms require random access iterators");
+		typedef typename std::iterator_traits<_RandomIt>::value_type value_type;
+		detail::for_chunks<value_type>(pool, static_cast<std::size_t>(last - first), [&](std::size_t b, std::size_t e)
+		{
+			std::fill(first + b, first + e, value);
+		});
+	}
+
+	template<
+		typename _RandomIt,
+		typename _Function
+	>
+	void for_each(_RandomIt first, _RandomIt last, _Function f, thread_pool& pool = thread_pool::default_pool())
+	{
+		static_assert(detail::is_random_access<_RandomIt>::value, "parallel algorithms require random access iterators");
+		typedef typename std::iterator_traits<_RandomIt>::value_type value_type;
+		detail::for_chunks<value_type>(pool, static_cast<std::size_t>(last - first), [&](std::size_t b, std::size_t e)
+		{
+			std::for_each(first + b, first + e, f);
+		});
+	}
+
+	// output must not overlap the input, as chunks are written in any order
+	template<
+		typename _RandomIt,
+		typename _OutputIt,
+		typename _UnaryOp
+	>
+	_OutputIt transform(_RandomIt first, _RandomIt last, _OutputIt out, _UnaryOp op, thread_pool& pool = thread_pool::default_pool())
+	{
+		static_assert(detail::is_random_access<_RandomIt>::value && detail::is_random_access<_OutputIt>::value,
+			"parallel algorithms require random access iterators");
+		typedef typename std::iterator_traits<_RandomIt>::value_type value_type;
+		detail::for_chunks<value_type>(pool, static_cast<std::size_t>(last - first), [&](std::size_t b, std::size_t e)
+		{
+			std::transform(first + b, first + e, out + b, op);
+		});
+		return out + (last - first);
+	}
+
+	template<
+		typename _RandomIt,
+		typename _OutputIt
+	>
+	_OutputIt copy(_RandomIt first, _RandomIt last, _OutputIt out, thread_pool& pool = thread_pool::default_pool())
+	{
+		static_assert(detail::is_random_access<_RandomIt>::value && detail::is_random_access<_OutputIt>::value,
+			"parallel algorithms require random access iterators");
+		typedef typename std::iterator_traits<_RandomIt>::value_type value_type;
+		detail::for_chunks<value_type>(pool, static_cast<std::size_t>(last - first), [&](std::size_t b, std::size_t e)
+		{
+			std::copy(first + b, first + e, out + b);
+		});
+		return out + (last - first);
+	}
+
+	// Combines init and all elements with op, which must be associative: every
+	// chunk is reduced on its own, the partial results are combined in order.
+	template<
+		typename _RandomIt,
+		typename _Ty,
+		typename _BinaryOp
+	>
+	_Ty reduce(_RandomIt first, _RandomIt last, _Ty init, _BinaryOp op, thread_pool& pool = thread_pool::default_pool())
+	{
+		static_assert(detail::is_random_access<_RandomIt>::value, "parallel algorithms require random access iterators");
+		typedef typename std::iterator_traits<_RandomIt>::value_type value_type;
+
+		std::mutex mutex;
+		std::vector<std::pair<std::size_t, _Ty>> partials;
+		detail::for_chunks<value_type>(pool, static_cast<std::size_t>(last - first), [&](std::size_t b, std::size_t e)
+		{
+			_Ty partial = std::accumulate(first + b + 1, first + e, _Ty(first[b]), op);
+			std::lock_guard<std::mutex> lock(mutex);
+			partials.emplace_back(b, std::move(partial));
+		});
+
+		std::sort(partials.begin(), partials.end(),
+			[](const std::pair<std::size_t, _Ty>& lhs, const std::pair<std::size_t, _Ty>& rhs) { return lhs.first < rhs.first; });
+		for(std::pair<std::size_t, _Ty>& partial : partials)
+			init = op(std::move(init), std::move(partial.second));
+		return init;
+	}
+
+	template<
+		typename _RandomIt,
+		typename _Ty
+	>
+	_Ty reduce(_RandomIt first, _RandomIt last, _Ty init, thread_pool& pool = thread_pool::default_pool())
+	{
+		return fcv_parallel::reduce(first, last, std::move(init), std::plus<_Ty>(), pool);
+	}
+
+	// Sorts the chunks in parallel, then merges neighbouring runs in rounds of
+	// doubling width, each round in parallel. Not stable.
+	template<
+		typename _RandomIt,
+		typename _Compare
+	>
+	void sort(_RandomIt first, _RandomIt last, _Compare comp, thread_pool& pool = thread_pool::default_pool())
+	{
+		static_assert(detail::is_random_access<_RandomIt>::value, "parallel algorithms require random access iterators");
+		typedef typename std::iterator_traits<_RandomIt>::value_type value_type;
+
+		const std::size_t n = static_cast<std::size_t>(last - first);
+		std::size_t run = 0;
+		std::mutex mutex;
+		detail::for_chunks<value_type>(pool, n, [&](std::size_t b, std::size_t e)
+		{
+			std::sort(first + b, first + e, comp);
+			std::lock_guard<std::mutex> lock(mutex);
+			run = std::max(run, e - b);	// all chunks but the last have the same size
+		});
+
+		for(; run < n; run *= 2)
+		{
+			const std::size_t merges = (n + 2 * run - 1) / (2 * run);
+			pool.run(merges, [&](std::size_t i)
+			{
+				const std::size_t b = i * 2 * run;
+				const std::size_t mid = std::min(n, b + run);
+				const std::size_t e = std::min(n, b + 2 * run);
+				std::inplace_merge(first + b, first + mid, first + e, comp);
+			});
+		}
+	}
+
+	template<
+		typename _RandomIt
+	>
+	void sort(_RandomIt first, _RandomIt last, thread_pool& pool = thread_pool::default_pool())
+	{
+		typedef typename std::iterator_traits<_RandomIt>::value_type value_type;
+		fcv_parallel::sort(first, last, std::less<value_type>(), pool);
+	}
+
+	namespace detail
+	{
+		enum copy_method { copy_bytes, copy_assign, copy_serial };
+
+		// bulk copyable elements are copied bytewise into untouched memory
+		template<typename _Vector>
+		void copy_elements(_Vector& to, const _Vector& from, thread_pool& pool, std::integral_constant<int, copy_bytes>)
+		{
+			typedef typename _Vector::value_type value_type;
+			to.resize_and_overwrite(from.size(), [&](value_type* data, typename _Vector::size_type size)
+			{
+				detail::for_chunks<value_type>(pool, size, [&](std::size_t b, std::size_t e)
+				{
+					std::memcpy(static_cast<void*>(data + b), static_cast<const void*>(from.data() + b), (e - b) * sizeof(value_type));
+				});
+				return size;
+			});
+		}
+
+		// other elements are default constructed and then assigned in parallel
+		template<typename _Vector>
+		void copy_elements(_Vector& to, const _Vector& from, thread_pool& pool, std::integral_constant<int, copy_assign>)
+		{
+			to.resize_and_overwrite(from.size(), [&](typename _Vector::value_type* data, typename _Vector::size_type size)
+			{
+				fcv_parallel::copy(from.data(), from.data() + size, data, pool);
+				return size;
+			});
+		}
+
+		template<typename _Vector>
+		void copy_elements(_Vector& to, const _Vector& from, thread_pool&, std::integral_constant<int, copy_serial>)
+		{
+			to.assign(from.begin(), from.end());
+		}
+	}
+
+	// Copy of v with the same capacity, equal to the copy constructor but with the
+	// elements copied in parallel. Elements that are not default constructible are
+	// copied serially.
+	template<
+		typename _Ty,
+		typename _Alloc,
+		typename _SizeType
+	>
+	fixed_capacity_vector<_Ty, _Alloc, _SizeType> copy_of(const fixed_capacity_vector<_Ty, _Alloc, _SizeType>& v,
+		thread_pool& pool = thread_pool::default_pool())
+	{
+		typedef fixed_capacity_vector<_Ty, _Alloc, _SizeType> vector_type;
+		const int method = !std::is_default_constructible<_Ty>::value ? detail::copy_serial
+			: fcv_detail::is_bulk_copyable<_Ty>::value && fcv_detail::uses_default_construct<_Alloc>::value ? detail::copy_bytes
+			: detail::copy_assign;
+
+		vector_type copy(v.capacity(), std::allocator_traits<_Alloc>::select_on_container_copy_construction(v.get_allocator()));
+		detail::copy_elements(copy, v, pool, std::integral_constant<int, method>());
+		return copy;
+	}
+}
@@ -0,0 +1,246 @@
+
+#pragma once
+
+#include "vector.h"
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+
+// Pool of equally sized blocks. Blocks are carved from slabs obtained from the
+// global operator new and recycled through an intrusive free list, so allocation
+// and deallocation are O(1) pointer pops and pushes. Slabs are only returned
+// when the pool is destroyed. A pool is not thread-safe, see
+// thread_local_block_pool() for one pool per thread.
+class block_pool
+{
+public:
+	block_pool(std::size_t blockSize, std::size_t blocksPerSlab = 64,
+		std::size_t alignment = std::alignment_of<std::max_align_t>::value)
+		: blockSize_(_round_up(blockSize < sizeof(free_block) ? sizeof(free_block) : blockSize, alignment))
+		, requestedSize_(blockSize), blocksPerSlab_(blocksPerSlab ? blocksPerSlab : 1), alignment_(alignment)
+		, free_(nullptr), slabs_(nullptr), carve_(nullptr), carveEnd_(nullptr)
+		, slabCount_(0), inUse_(0), freeCount_(0)
+	{
+		assert(alignment && !(alignment & (alignment - 1)) && "alignment must be a power of two");
+	}
+
+	block_pool(const block_pool&) = delete;
+	block_pool& operator=(const block_pool&) = delete;
+
+	~block_pool() FCV_NOEXCEPT
+	{
+		assert(!inUse_ && "block_pool destroyed while blocks are still in use");
+		while(slabs_)
+		{
+			slab* next = slabs_->next;
+			::operator delete(slabs_);
+			slabs_ = next;
+		}
+	}
+
+	void* allocate()
+	{
+		char* p;
+		if(free_)
+		{
+			p = reinterpret_cast<char*>(free_);
+			free_ = free_->next;
+			--freeCount_;
+		}
+		else
+		{
+			if(carve_ == carveEnd_)
+				_new_slab();
+			p = carve_;
+			carve_ += blockSize_;
+		}
+		++inUse_;
+		return p;
+	}
+
+	void deallocate(void* p) FCV_NOEXCEPT
+	{
+		assert(p && inUse_);
+		free_block* b = static_cast<free_block*>(p);
+		b->next = free_;
+		free_ = b;
+		++freeCount_;
+		--inUse_;
+	}
+
+	// size of the blocks as requested on construction
+	std::size_t block_size() const FCV_NOEXCEPT
+	{
+		return requestedSize_;
+	}
+
+	std::size_t alignment() const FCV_NOEXCEPT
+	{
+		return alignment_;
+	}
+
+	std::size_t blocks_per_slab() const FCV_NOEXCEPT
+	{
+		return blocksPerSlab_;
+	}
+
+	std::size_t slab_count() const FCV_NOEXCEPT
+	{
+		return slabCount_;
+	}
+
+	std::size_t blocks_in_use() const FCV_NOEXCEPT
+	{
+		return inUse_;
+	}
+
+	// blocks that can be handed out without requesting a new slab
+	std::size_t blocks_free() const FCV_NOEXCEPT
+	{
+		return freeCount_ + static_cast<std::size_t>(carveEnd_ - carve_) / blockSize_;
+	}
+
+	// fraction of all blocks of all slabs that is in use
+	double occupancy() const FCV_NOEXCEPT
+	{
+		return slabCount_ ? static_cast<double>(inUse_) / static_cast<double>(slabCount_ * blocksPerSlab_) : 0.0;
+	}
+
+private:
+	struct free_block
+	{
+		free_block* next;
+	};
+
+	struct slab
+	{
+		slab* next;
+	};
+
+	static std::size_t _round_up(std::size_t n, std::size_t alignment) FCV_NOEXCEPT
+	{
+		return (n + alignment - 1) & ~(alignment - 1);
+	}
+
+	void _new_slab()
+	{
+		const std::size_t header = _round_up(sizeof(slab), alignment_);
+		if(blocksPerSlab_ > (static_cast<std::size_t>(-1) - header - alignment_) / blockSize_)
+			throw std::bad_alloc();
+
+		// over-allocate so the first block can be aligned beyond what operator new guarantees
+		slab* s = static_cast<slab*>(::operator new(header + blocksPerSlab_ * blockSize_ + alignment_));
+		s->next = slabs_;
+		slabs_ = s;
+		++slabCount_;
+
+		const std::uintptr_t first = reinterpret_cast<std::uintptr_t>(s) + header;
+		carve_ = reinterpret_cast<char*>(_round_up(first, alignment_));
+		carveEnd_ = carve_ + blocksPerSlab_ * blockSize_;
+	}
+
+private:
+	std::size_t blockSize_;
+	std::size_t requestedSize_;
+	std::size_t blocksPerSlab_;
+	std::size_t alignment_;
+	free_block* free_;
+	slab* slabs_;
+	char* carve_;		// untouched part of the newest slab
+	char* carveEnd_;
+	std::size_t slabCount_;
+	std::size_t inUse_;
+	std::size_t freeCount_;
+};
+
+
+// One pool per thread and block size. Memory from a thread local pool must be
+// given back on the thread that allocated it, so containers using it must not
+// outlive their thread or be destroyed on another one.
+template<
+	std::size_t BlockSize,
+	std::size_t BlocksPerSlab = 64
+>
+block_pool& thread_local_block_pool()
+{
+	static thread_local block_pool pool(BlockSize, BlocksPerSlab);
+	return pool;
+}
+
+
+// Allocator serving all requests that fit into one block from a block_pool,
+// larger ones fall back to the global operator new. Copies refer to the same
+// pool and compare equal exactly if they do. Like arena_allocator it follows
+// its memory on move assignment and swap but not on copy assignment.
+template<
+	typename T
+>
+class pool_allocator
+{
+public:
+	typedef T value_type;
+	typedef std::false_type propagate_on_container_copy_assignment;
+	typedef std::true_type propagate_on_container_move_assignment;
+	typedef std::true_type propagate_on_container_swap;
+
+	template<typename U>
+	struct rebind { typedef pool_allocator<U> other; };
+
+	pool_allocator(block_pool& pool) FCV_NOEXCEPT
+		: pool_(&pool)
+	{
+	}
+
+	template<typename U>
+	pool_allocator(const pool_allocator<U>& other) FCV_NOEXCEPT
+		: pool_(other.pool_)
+	{
+	}
+
+	value_type* allocate(std::size_t n)
+	{
+		if(_fits(n))
+			return static_cast<value_type*>(pool_->allocate());
+		if(n > static_cast<std::size_t>(-1) / sizeof(value_type))
+			throw std::bad_alloc();
+		return static_cast<value_type*>(::operator new(n * sizeof(value_type)));
+	}
+
+	void deallocate(value_type* p, std::size_t n) FCV_NOEXCEPT
+	{
+		if(_fits(n))
+			pool_->deallocate(p);
+		else
+			::operator delete(p);
+	}
+
+	block_pool& pool() const FCV_NOEXCEPT
+	{
+		return *pool_;
+	}
+
+private:
+	template<typename U>
+	friend class pool_allocator;
+
+	bool _fits(std::size_t n) const FCV_NOEXCEPT
+	{
+		return n <= pool_->block_size() / sizeof(value_type)
+			&& std::alignment_of<value_type>::value <= pool_->alignment();
+	}
+
+	block_pool* pool_;
+};
+
+
+template<typename T, typename U>
+bool operator==(const pool_allocator<T>& lhs, const pool_allocator<U>& rhs)
+{
+	return &lhs.pool() == &rhs.pool();
+}
+template<typename T, typename U>
+bool operator!=(const pool_allocator<T>& lhs, const pool_allocator<U>& rhs)
+{
+	return !operator==(lhs, rhs);
+}
@@ -0,0 +1,43 @@
+
+#pragma once
+
+#include "vector.h"
+#include <cerrno>
+#include <climits>
+#include <cstddef>
+#include <string>
+#include <system_error>
+
+// Error handling and retries around POSIX calls shared by the file, shared memory
+// and file descriptor I/O headers.
+namespace fcv_detail
+{
+	// throws std::system_error for error, by default the errno of the failed call
+	inline void throw_errno(const std::string& what, int error = errno)
+	{
+		throw std::system_error(error, std::generic_category(), what);
+	}
+
+	// number of buffers readv() and writev() accept in one call
+	inline std::size_t iov_max() FCV_NOEXCEPT
+	{
+#ifdef IOV_MAX
+		return IOV_MAX;
+#else
+		return 1024;
+#endif
+	}
+
+	// calls op, which returns the result of a system call, until it does not fail
+	// with EINTR; errno is left as set by the last call
+	template<typename _Op>
+	auto retry_on_eintr(_Op op) -> decltype(op())
+	{
+		for(;;)
+		{
+			const auto result = op();
+			if(result >= 0 || errno != EINTR)
+				return result;
+		}
+	}
+}
@@ -0,0 +1,607 @@
+
+#pragma once
+
+#include "vector.h"
+#include <atomic>
+#include <stdexcept>
+
+namespace fcv_detail
+{
+	// random access iterator over the logical positions of a ring buffer
+	template<typename _Ty>
+	class ring_iterator
+	{
+	public:
+		typedef std::random_access_iterator_tag iterator_category;
+		typedef typename std::remove_const<_Ty>::type value_type;
+		typedef std::ptrdiff_t difference_type;
+		typedef _Ty* pointer;
+		typedef _Ty& reference;
+
+		ring_iterator()
+			: buffer_(nullptr), capacity_(0), head_(0), index_(0)
+		{
+		}
+
+		ring_iterator(_Ty* buffer, std::size_t capacity, std::size_t head, std::size_t index)
+			: buffer_(buffer), capacity_(capacity), head_(head), index_(index)
+		{
+		}
+
+		// iterator to const_iterator conversion
+		template<typename _Other, typename = typename std::enable_if<std::is_convertible<_Other*, _Ty*>::value>::type>
+		ring_iterator(const ring_iterator<_Other>& other)
+			: buffer_(other.buffer_), capacity_(other.capacity_), head_(other.head_), index_(other.index_)
+		{
+		}
+
+		reference operator*() const { return buffer_[_physical(index_)]; }
+		pointer operator->() const { return buffer_ + _physical(index_); }
+		reference operator[](difference_type n) const { return buffer_[_physical(index_ + n)]; }
+
+		ring_iterator& operator++() { ++index_; return *this; }
+		ring_iterator operator++(int) { ring_iterator tmp(*this); ++index_; return tmp; }
+		ring_iterator& operator--() { --index_; return *this; }
+		ring_iterator operator--(int) { ring_iterator tmp(*this); --index_; return tmp; }
+		ring_iterator& operator+=(difference_type n) { index_ += n; return *this; }
+		ring_iterator& operator-=(difference_type n) { index_ -= n; return *this; }
+		ring_iterator operator+(difference_type n) const { return ring_iterator(buffer_, capacity_, head_, index_ + n); }
+		ring_iterator operator-(difference_type n) const { return ring_iterator(buffer_, capacity_, head_, index_ - n); }
+		friend ring_iterator operator+(difference_type n, const ring_iterator& it) { return it + n; }
+
+		template<typename _Other>
+		difference_type operator-(const ring_iterator<_Other>& other) const
+		{
+			return static_cast<difference_type>(index_) - static_cast<difference_type>(other.index_);
+		}
+
+		template<typename _Other> bool operator==(const ring_iterator<_Other>& other) const { return index_ == other.index_; }
+		template<typename _Other> bool operator!=(const ring_iterator<_Other>& other) const { return index_ != other.index_; }
+		template<typename _Other> bool operator<(const ring_iterator<_Other>& other) const { return index_ < other.index_; }
+		template<typename _Other> bool operator>(const ring_iterator<_Other>& other) const { return index_ > other.index_; }
+		template<typename _Other> bool operator<=(const ring_iterator<_Other>& other) const { return index_ <= other.index_; }
+		template<typename _Other> bool operator>=(const ring_iterator<_Other>& other) const { return index_ >= other.index_; }
+
+	private:
+		template<typename _Other>
+		friend class ring_iterator;
+
+		std::size_t _physical(std::size_t index) const
+		{
+			const std::size_t i = head_ + index;
+			return i < capacity_ ? i : i - capacity_;
+		}
+
+		_Ty* buffer_;
+		std::size_t capacity_;
+		std::size_t head_;
+		std::size_t index_;	// logical position relative to the front
+	};
+}
+
+// Double ended queue over one allocation of capacity elements. Elements are
+// stored in a circular buffer, so pushing and popping at either end is O(1)
+// and never moves other elements, unlike erase(begin()) on a
+// fixed_capacity_vector. Like the vector it never reallocates and throws
+// std::length_error when it runs out of capacity; elements are created and
+// destroyed through allocator_traits.
+template<
+	typename _Ty,
+	typename _Alloc = std::allocator<_Ty>
+>
+class fixed_capacity_ring_buffer
+{
+public:
+	typedef _Ty value_type;
+	typedef _Alloc allocator_type;
+	typedef unsigned int size_type;
+	typedef fcv_detail::ring_iterator<value_type> iterator;
+	typedef fcv_detail::ring_iterator<const value_type> const_iterator;
+	typedef std::reverse_iterator<iterator> reverse_iterator;
+	typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+	explicit fixed_capacity_ring_buffer(size_type _capacity, const allocator_type& allocator = allocator_type())
+		: buffer_(nullptr), capacity_(0), head_(0), size_(0), allocator_(allocator)
+	{
+		_alloc(_capacity);
+	}
+
+	fixed_capacity_ring_buffer(const fixed_capacity_ring_buffer& other)
+		: buffer_(nullptr), capacity_(0), head_(0), size_(0)
+		, allocator_(std::allocator_traits<allocator_type>::select_on_container_copy_construction(other.allocator_))
+	{
+		_alloc(other.capacity());
+		_copy_elements(other);
+	}
+
+	fixed_capacity_ring_buffer(fixed_capacity_ring_buffer&& other) FCV_NOEXCEPT
+		: buffer_(nullptr), capacity_(0), head_(0), size_(0), allocator_(std::move(other.allocator_))
+	{
+		_swap_state(*this, other);
+	}
+
+	fixed_capacity_ring_buffer& operator=(const fixed_capacity_ring_buffer& other)
+	{
+		if(this != &other)
+		{
+			clear();
+			if(std::allocator_traits<allocator_type>::propagate_on_container_copy_assignment::value
+				&& allocator_ != other.allocator_)
+			{
+				_free();
+				allocator_ = other.allocator_;
+				_alloc(other.capacity());
+			}
+			else if(capacity_ != other.capacity())
+			{
+				_free();
+				_alloc(other.capacity());
+			}
+			_copy_elements(other);
+		}
+		return *this;
+	}
+
+	fixed_capacity_ring_buffer& operator=(fixed_capacity_ring_buffer&& other)
+	{
+		if(this != &other)
+		{
+			clear();
+			if(!std::allocator_traits<allocator_type>::propagate_on_container_move_assignment::value
+				&& allocator_ != other.allocator_)
+			{
+				// the buffer of other cannot be freed by our allocator, so move the elements
+				if(capacity_ != other.capacity())
+				{
+					_free();
+					_alloc(other.capacity());
+				}
+				for(auto& element : other)
+					emplace_back(std::move(element));
+				other.clear();
+				return *this;
+			}
+
+			_free();
+			if(std::allocator_traits<allocator_type>::propagate_on_container_move_assignment::value
+				&& allocator_ != other.allocator_)
+			{
+				allocator_ = std::move(other.allocator_);
+			}
+			_swap_state(*this, other);
+		}
+		return *this;
+	}
+
+	void swap(fixed_capacity_ring_buffer& other) FCV_NOEXCEPT
+	{
+		if(this != &other)
+		{
+			using std::swap;
+			if(std::allocator_traits<allocator_type>::propagate_on_container_swap::value)
+				swap(allocator_, other.allocator_);
+			_swap_state(*this, other);
+		}
+	}
+
+	~fixed_capacity_ring_buffer() FCV_NOEXCEPT
+	{
+		clear();
+		_free();
+	}
+
+	allocator_type get_allocator() const
+	{
+		return allocator_;
+	}
+
+	size_type capacity() const FCV_NOEXCEPT
+	{
+		return capacity_;
+	}
+
+	size_type size() const FCV_NOEXCEPT
+	{
+		return size_;
+	}
+
+	bool empty() const FCV_NOEXCEPT
+	{
+		return size_ == 0;
+	}
+
+	bool full() const FCV_NOEXCEPT
+	{
+		return size_ == capacity_;
+	}
+
+	template<
+		typename... _TyArgs
+	>
+	value_type& emplace_back(_TyArgs&&... args)
+	{
+		if(full())
+			throw std::length_error("fixed_capacity_ring_buffer out of capacity");
+
+		value_type* dst = buffer_ + _physical(size_);
+		std::allocator_traits<allocator_type>::construct(allocator_, dst, std::forward<_TyArgs>(args)...);
+		// modify size after construction to be consistent if the constructor throws
+		++size_;
+		return *dst;
+	}
+
+	void push_back(const value_type& value)
+	{
+		emplace_back(value);
+	}
+
+	void push_back(value_type&& value)
+	{
+		emplace_back(std::move(value));
+	}
+
+	template<
+		typename... _TyArgs
+	>
+	value_type& emplace_front(_TyArgs&&... args)
+	{
+		if(full())
+			throw std::length_error("fixed_capacity_ring_buffer out of capacity");
+
+		const size_type head = head_ ? head_ - 1 : capacity_ - 1;
+		std::allocator_traits<allocator_type>::construct(allocator_, buffer_ + head, std::forward<_TyArgs>(args)...);
+		head_ = head;
+		++size_;
+		return buffer_[head];
+	}
+
+	void push_front(const value_type& value)
+	{
+		emplace_front(value);
+	}
+
+	void push_front(value_type&& value)
+	{
+		emplace_front(std::move(value));
+	}
+
+	void pop_front()
+	{
+		assert(!empty() && "pop_front() called on empty ring buffer");
+		if(!empty())
+		{
+			value_type* p = buffer_ + head_;
+			head_ = head_ + 1 == capacity_ ? 0 : head_ + 1;
+			--size_;
+			_destroy(p);
+		}
+	}
+
+	void pop_back()
+	{
+		assert(!empty() && "pop_back() called on empty ring buffer");
+		if(!empty())
+		{
+			--size_;
+			_destroy(buffer_ + _physical(size_));
+		}
+	}
+
+	void clear() FCV_NOEXCEPT
+	{
+		if(_req_destruction)
+		{
+			while(!empty())
+				pop_back();
+		}
+		size_ = 0;
+		head_ = 0;
+	}
+
+	value_type& front()
+	{
+		assert(!empty() && "calling front() on empty container has undefined behavior");
+		return buffer_[head_];
+	}
+
+	const value_type& front() const
+	{
+		assert(!empty() && "calling front() on empty container has undefined behavior");
+		return buffer_[head_];
+	}
+
+	value_type& back()
+	{
+		assert(!empty() && "calling back() on empty container has undefined behavior");
+		return buffer_[_physical(size_ - 1)];
+	}
+
+	const value_type& back() const
+	{
+		assert(!empty() && "calling back() on empty container has undefined behavior");
+		return buffer_[_physical(size_ - 1)];
+	}
+
+	value_type& at(size_type index)
+	{
+		assert(index < size_);
+		return buffer_[_physical(index)];
+	}
+
+	const value_type& at(size_type index) const
+	{
+		assert(index < size_);
+		return buffer_[_physical(index)];
+	}
+
+	value_type& operator[](size_type index)
+	{
+		return at(index);
+	}
+
+	const value_type& operator[](size_type index) const
+	{
+		return at(index);
+	}
+
+	iterator begin() FCV_NOEXCEPT
+	{
+		return iterator(buffer_, capacity_, head_, 0);
+	}
+
+	const_iterator begin() const FCV_NOEXCEPT
+	{
+		return cbegin();
+	}
+
+	const_iterator cbegin() const FCV_NOEXCEPT
+	{
+		return const_iterator(buffer_, capacity_, head_, 0);
+	}
+
+	iterator end() FCV_NOEXCEPT
+	{
+		return iterator(buffer_, capacity_, head_, size_);
+	}
+
+	const_iterator end() const FCV_NOEXCEPT
+	{
+		return cend();
+	}
+
+	const_iterator cend() const FCV_NOEXCEPT
+	{
+		return const_iterator(buffer_, capacity_, head_, size_);
+	}
+
+	reverse_iterator rbegin() FCV_NOEXCEPT
+	{
+		return reverse_iterator(end());
+	}
+
+	const_reverse_iterator rbegin() const FCV_NOEXCEPT
+	{
+		return const_reverse_iterator(end());
+	}
+
+	reverse_iterator rend() FCV_NOEXCEPT
+	{
+		return reverse_iterator(begin());
+	}
+
+	const_reverse_iterator rend() const FCV_NOEXCEPT
+	{
+		return const_reverse_iterator(begin());
+	}
+
+private:
+	enum { _req_destruction = !std::is_trivially_destructible<value_type>::value };
+
+	size_type _physical(size_type index) const FCV_NOEXCEPT
+	{
+		// head_ < capacity_ and index <= capacity_, so one subtraction wraps around
+		return index < capacity_ - head_ ? head_ + index : index - (capacity_ - head_);
+	}
+
+	void _alloc(size_type _capacity)
+	{
+		assert(!buffer_);
+		buffer_ = _capacity ? std::allocator_traits<allocator_type>::allocate(allocator_, _capacity) : nullptr;
+		capacity_ = _capacity;
+		head_ = 0;
+	}
+
+	void _free() FCV_NOEXCEPT
+	{
+		if(buffer_)
+			std::allocator_traits<allocator_type>::deallocate(allocator_, buffer_, capacity_);
+		buffer_ = nullptr;
+		capacity_ = 0;
+	}
+
+	void _copy_elements(const fixed_capacity_ring_buffer& other)
+	{
+		assert(empty() && capacity_ >= other.size());
+		try
+		{
+			for(const auto& element : other)
+				emplace_back(element);
+		}
+		catch(...)
+		{
+			clear();
+			throw;
+		}
+	}
+
+	void _destroy(value_type* p)
+	{
+		if(_req_destruction)
+			std::allocator_traits<allocator_type>::destroy(allocator_, p);
+	}
+
+	static void _swap_state(fixed_capacity_ring_buffer& lhs, fixed_capacity_ring_buffer& rhs) FCV_NOEXCEPT
+	{
+		std::swap(lhs.buffer_, rhs.buffer_);
+		std::swap(lhs.capacity_, rhs.capacity_);
+		std::swap(lhs.head_, rhs.head_);
+		std::swap(lhs.size_, rhs.size_);
+	}
+
+private:
+	value_type* buffer_;
+	size_type capacity_;
+	size_type head_;	// physical index of the front element
+	size_type size_;
+	allocator_type allocator_;
+};
+
+template<typename _Ty, typename _Alloc>
+void swap(fixed_capacity_ring_buffer<_Ty, _Alloc>& lhs, fixed_capacity_ring_buffer<_Ty, _Alloc>& rhs) FCV_NOEXCEPT
+{
+	lhs.swap(rhs);
+}
+
+
+// Bounded lock-free queue between exactly one producer thread and one consumer
+// thread. The producer only writes the tail index and the consumer only the
+// head index; both live on their own cache line together with a cached copy
+// of the other side's index, so the shared line is only read when the cached
+// value says the queue looks full (producer) or empty (consumer). One slot more
+// than the capacity is allocated to tell a full queue from an empty one.
+template<
+	typename _Ty,
+	typename _Alloc = std::allocator<_Ty>
+>
+class spsc_ring_buffer
+{
+public:
+	typedef _Ty value_type;
+	typedef _Alloc allocator_type;
+	typedef unsigned int size_type;
+
+	explicit spsc_ring_buffer(size_type _capacity, const allocator_type& allocator = allocator_type())
+		: buffer_(nullptr), slots_(_capacity + 1), allocator_(allocator)
+		, tail_(0), cachedHead_(0), head_(0), cachedTail_(0)
+	{
+		if(slots_ < _capacity)
+			throw std::length_error("capacity of spsc_ring_buffer too large");
+		buffer_ = std::allocator_traits<allocator_type>::allocate(allocator_, slots_);
+	}
+
+	spsc_ring_buffer(const spsc_ring_buffer&) = delete;
+	spsc_ring_buffer& operator=(const spsc_ring_buffer&) = delete;
+
+	// must not run concurrently with the producer or the consumer
+	~spsc_ring_buffer() FCV_NOEXCEPT
+	{
+		size_type head = head_.load(std::memory_order_acquire);
+		const size_type tail = tail_.load(std::memory_order_acquire);
+		for(; head != tail; head = _next(head))
+			std::allocator_traits<allocator_type>::destroy(allocator_, buffer_ + head);
+		std::allocator_traits<allocator_type>::deallocate(allocator_, buffer_, slots_);
+	}
+
+	size_type capacity() const FCV_NOEXCEPT
+	{
+		return slots_ - 1;
+	}
+
+	// number of queued elements; exact only when called by the producer or the consumer
+	// while the other side is idle
+	size_type size_approx() const FCV_NOEXCEPT
+	{
+		const size_type head = head_.load(std::memory_order_acquire);
+		const size_type tail = tail_.load(std::memory_order_acquire);
+		return tail >= head ? tail - head : slots_ - head + tail;
+	}
+
+	bool empty() const FCV_NOEXCEPT
+	{
+		return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+	}
+
+	// producer: constructs an element at the tail, returns false if the queue is full
+	template<
+		typename... _TyArgs
+	>
+	bool try_emplace(_TyArgs&&... args)
+	{
+		const size_type tail = tail_.load(std::memory_order_relaxed);
+		const size_type next = _next(tail);
+		if(next == cachedHead_)
+		{
+			cachedHead_ = head_.load(std::memory_order_acquire);
+			if(next == cachedHead_)
+				return false;
+		}
+		std::allocator_traits<allocator_type>::construct(allocator_, buffer_ + tail, std::forward<_TyArgs>(args)...);
+		tail_.store(next, std::memory_order_release);
+		return true;
+	}
+
+	bool try_push(const value_type& value)
+	{
+		return try_emplace(value);
+	}
+
+	bool try_push(value_type&& value)
+	{
+		return try_emplace(std::move(value));
+	}
+
+	// consumer: moves the front element into value, returns false if the queue is empty
+	bool try_pop(value_type& value)
+	{
+		value_type* p = front();
+		if(!p)
+			return false;
+		value = std::move(*p);
+		pop();
+		return true;
+	}
+
+	// consumer: the front element or nullptr if the queue is empty, stays valid until pop()
+	value_type* front()
+	{
+		const size_type head = head_.load(std::memory_order_relaxed);
+		if(head == cachedTail_)
+		{
+			cachedTail_ = tail_.load(std::memory_order_acquire);
+			if(head == cachedTail_)
+				return nullptr;
+		}
+		return buffer_ + head;
+	}
+
+	// consumer: destroys the front element, front() must have returned it
+	void pop()
+	{
+		const size_type head = head_.load(std::memory_order_relaxed);
+		assert(head != tail_.load(std::memory_order_acquire) && "pop() called on empty spsc_ring_buffer");
+		std::allocator_traits<allocator_type>::destroy(allocator_, buffer_ + head);
+		head_.store(_next(head), std::memory_order_release);
+	}
+
+private:
+	size_type _next(size_type index) const FCV_NOEXCEPT
+	{
+		return index + 1 == slots_ ? 0 : index + 1;
+	}
+
+private:
+	value_type* buffer_;
+	size_type slots_;
+	allocator_type allocator_;
+	// a full cache line of padding around each index group keeps it on lines of its
+	// own wherever the queue is placed; alignas would not be honoured by new before C++17
+	char pad0_[64];
+	// written by the producer
+	std::atomic<size_type> tail_;
+	size_type cachedHead_;
+	char pad1_[64];
+	// written by the consumer
+	std::atomic<size_type> head_;
+	size_type cachedTail_;
+	char pad2_[64];
+};
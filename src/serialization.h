@@ -0,0 +1,381 @@
+
+#pragma once
+
+#include "posix_io.h"
+#include "vector.h"
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include <sys/uio.h>
+#include <unistd.h>
+
+// Binary records of a vector on a file descriptor: a record_header followed by
+// the payload. Trivially copyable elements are stored as the raw bytes of data(),
+// written and read with a single writev/read instead of element by element.
+// Strings and byte vectors are stored length prefixed: the lengths of all
+// elements, then all their bytes, again moved with one vectored call per batch.
+// Reading them resizes every element first, which allocates for each element
+// that does not fit into its current buffer, so load() and reads into fresh
+// elements allocate once per string longer than the small string buffer. Only
+// reading into a vector whose elements already have the capacity, e.g. the same
+// vector in a loop over records of similar size, avoids these allocations.
+// Records can be concatenated, e.g. by stream_writer, and read back one by one.
+namespace fcv_serialization
+{
+	enum class encoding : std::uint32_t
+	{
+		raw = 0,
+		length_prefixed = 1
+	};
+
+	struct record_header
+	{
+		std::uint32_t magic;
+		std::uint16_t version;
+		std::uint16_t header_size;
+		std::uint32_t byte_order;		// byte_order_mark as written, byte swapped if the writer had another endianness
+		std::uint32_t element_size;		// sizeof the element, 1 for length prefixed elements
+		std::uint32_t encoding;
+		std::uint32_t reserved;
+		std::uint64_t count;
+		std::uint64_t capacity;			// of the written vector, used by load()
+
+		enum : std::uint32_t { expected_magic = 0x53564346u };	// "FCVS" read little endian
+		enum : std::uint16_t { current_version = 1 };
+		enum : std::uint32_t { byte_order_mark = 0x01020304u };
+	};
+	static_assert(sizeof(record_header) == 40, "record_header must not contain padding");
+
+	// element types stored with encoding::length_prefixed, can be specialized for
+	// other contiguous sequences of chars with size(), resize() and data()
+	template<typename _Ty>
+	struct is_length_prefixed : std::false_type
+	{
+	};
+
+	template<typename _Traits, typename _Alloc>
+	struct is_length_prefixed<std::basic_string<char, _Traits, _Alloc>> : std::true_type
+	{
+	};
+
+	template<typename _Alloc>
+	struct is_length_prefixed<std::vector<char, _Alloc>> : std::true_type
+	{
+	};
+
+	namespace detail
+	{
+		// writes all buffers, continuing after partial writes and interruptions
+		inline void write_all(int fd, ::iovec* iov, std::size_t count)
+		{
+			while(count)
+			{
+				const ::ssize_t written = fcv_detail::retry_on_eintr([&]
+				{
+					return ::writev(fd, iov, static_cast<int>(std::min(count, fcv_detail::iov_max())));
+				});
+				if(written < 0)
+					fcv_detail::throw_errno("writev failed");
+
+				std::size_t left = static_cast<std::size_t>(written);
+				while(count && left >= iov->iov_len)
+				{
+					left -= iov->iov_len;
+					++iov;
+					--count;
+				}
+				if(count)
+				{
+					iov->iov_base = static_cast<char*>(iov->iov_base) + left;
+					iov->iov_len -= left;
+				}
+			}
+		}
+
+		// fills all buffers, returns the number of bytes read before end of file
+		inline std::size_t read_all(int fd, ::iovec* iov, std::size_t count)
+		{
+			std::size_t total = 0;
+			while(count)
+			{
+				const ::ssize_t got = fcv_detail::retry_on_eintr([&]
+				{
+					return ::readv(fd, iov, static_cast<int>(std::min(count, fcv_detail::iov_max())));
+				});
+				if(got < 0)
+					fcv_detail::throw_errno("readv failed");
+				if(got == 0)
+					break;
+
+				total += static_cast<std::size_t>(got);
+				std::size_t left = static_cast<std::size_t>(got);
+				while(count && left >= iov->iov_len)
+				{
+					left -= iov->iov_len;
+					++iov;
+					--count;
+				}
+				if(count)
+				{
+					iov->iov_base = static_cast<char*>(iov->iov_base) + left;
+					iov->iov_len -= left;
+				}
+			}
+			return total;
+		}
+
+		inline void read_exactly(int fd, ::iovec* iov, std::size_t count)
+		{
+			std::size_t expected = 0;
+			for(std::size_t i = 0; i < count; ++i)
+				expected += iov[i].iov_len;
+			if(read_all(fd, iov, count) != expected)
+				throw std::runtime_error("record truncated by end of file");
+		}
+
+		template<typename _Ty>
+		struct encoding_of : std::integral_constant<encoding,
+			is_length_prefixed<_Ty>::value ? encoding::length_prefixed : encoding::raw>
+		{
+			static_assert(std::is_trivially_copyable<_Ty>::value || is_length_prefixed<_Ty>::value,
+				"only trivially copyable and length prefixed elements can be serialized");
+		};
+
+		template<typename _Vector>
+		record_header make_header(const _Vector& v)
+		{
+			typedef typename _Vector::value_type value_type;
+			record_header header = record_header();
+			header.magic = record_header::expected_magic;
+			header.version = record_header::current_version;
+			header.header_size = sizeof(record_header);
+			header.byte_order = record_header::byte_order_mark;
+			header.element_size = is_length_prefixed<value_type>::value ? 1 : static_cast<std::uint32_t>(sizeof(value_type));
+			header.encoding = static_cast<std::uint32_t>(encoding_of<value_type>::value);
+			header.count = v.size();
+			header.capacity = v.capacity();
+			return header;
+		}
+
+		template<typename _Vector>
+		void write_payload(int fd, record_header& header, const _Vector& v, std::integral_constant<encoding, encoding::raw>)
+		{
+			::iovec iov[2] = {
+				{ &header, sizeof(header) },
+				{ const_cast<typename _Vector::value_type*>(v.data()), v.size() * sizeof(typename _Vector::value_type) }
+			};
+			write_all(fd, iov, v.size() ? 2 : 1);
+		}
+
+		template<typename _Vector>
+		void write_payload(int fd, record_header& header, const _Vector& v, std::integral_constant<encoding, encoding::length_prefixed>)
+		{
+			std::vector<std::uint64_t> lengths(v.size());
+			std::vector<::iovec> iov;
+			iov.reserve(v.size() + 2);
+			iov.push_back({ &header, sizeof(header) });
+			iov.push_back({ lengths.data(), lengths.size() * sizeof(std::uint64_t) });
+			for(std::size_t i = 0; i < lengths.size(); ++i)
+			{
+				lengths[i] = v[i].size();
+				if(lengths[i])
+					iov.push_back({ const_cast<char*>(&v[i][0]), v[i].size() });
+			}
+			write_all(fd, iov.data(), iov.size());
+		}
+
+		template<typename _Vector>
+		void read_payload(int fd, const record_header& header, _Vector& v, std::integral_constant<encoding, encoding::raw>)
+		{
+			typedef typename _Vector::value_type value_type;
+			v.resize_and_overwrite(static_cast<typename _Vector::size_type>(header.count), [&](value_type* data, typename _Vector::size_type size)
+			{
+				::iovec iov = { data, size * sizeof(value_type) };
+				read_exactly(fd, &iov, 1);
+				return size;
+			});
+		}
+
+		// the bytes are read straight into the elements; resizing them allocates
+		// unless they kept large enough buffers from an earlier record
+		template<typename _Vector>
+		void read_payload(int fd, const record_header& header, _Vector& v, std::integral_constant<encoding, encoding::length_prefixed>)
+		{
+			std::vector<std::uint64_t> lengths(static_cast<std::size_t>(header.count));
+			::iovec lengthsIov = { lengths.data(), lengths.size() * sizeof(std::uint64_t) };
+			read_exactly(fd, &lengthsIov, 1);
+
+			v.resize(static_cast<typename _Vector::size_type>(header.count));
+			std::vector<::iovec> iov;
+			iov.reserve(lengths.size());
+			for(std::size_t i = 0; i < lengths.size(); ++i)
+			{
+				v[i].resize(static_cast<std::size_t>(lengths[i]));
+				if(lengths[i])
+					iov.push_back({ &v[i][0], v[i].size() });
+			}
+			read_exactly(fd, iov.data(), iov.size());
+		}
+
+		// false on end of file before the first byte of the header
+		template<typename _Ty>
+		bool read_header(int fd, record_header& header)
+		{
+			::iovec iov = { &header, sizeof(header) };
+			const std::size_t got = read_all(fd, &iov, 1);
+			if(got == 0)
+				return false;
+			if(got != sizeof(header))
+				throw std::runtime_error("record header truncated by end of file");
+
+			if(header.magic != record_header::expected_magic || header.header_size != sizeof(record_header))
+			{
+				if(header.magic == __builtin_bswap32(record_header::expected_magic))
+					throw std::runtime_error("record was written on a machine with a different byte order");
+				throw std::runtime_error("not a serialized vector record");
+			}
+			if(header.version != record_header::current_version)
+				throw std::runtime_error("unsupported version of serialized vector record");
+			if(header.byte_order != record_header::byte_order_mark)
+				throw std::runtime_error("record was written on a machine with a different byte order");
+			if(header.encoding != static_cast<std::uint32_t>(encoding_of<_Ty>::value)
+				|| header.element_size != (is_length_prefixed<_Ty>::value ? 1 : sizeof(_Ty)))
+				throw std::runtime_error("record holds elements of another type");
+			return true;
+		}
+	}
+
+	// writes v as one record
+	template<
+		typename _Vector
+	>
+	void write(int fd, const _Vector& v)
+	{
+		typedef typename _Vector::value_type value_type;
+		record_header header = detail::make_header(v);
+		detail::write_payload(fd, header, v, detail::encoding_of<value_type>());
+	}
+
+	// Replaces the elements of v with the next record. Returns false at end of
+	// file before the record; throws std::length_error if the record holds more
+	// elements than v has capacity for, after consuming only its header.
+	template<
+		typename _Vector
+	>
+	bool try_read(int fd, _Vector& v)
+	{
+		typedef typename _Vector::value_type value_type;
+		record_header header;
+		if(!detail::read_header<value_type>(fd, header))
+			return false;
+		if(header.count > v.capacity())
+			throw std::length_error("record holds more elements than the capacity of the vector");
+		detail::read_payload(fd, header, v, detail::encoding_of<value_type>());
+		return true;
+	}
+
+	template<
+		typename _Vector
+	>
+	void read(int fd, _Vector& v)
+	{
+		if(!try_read(fd, v))
+			throw std::runtime_error("end of file instead of a serialized vector record");
+	}
+
+	// reads the next record into a new vector with the capacity it was written with
+	template<
+		typename _Vector
+	>
+	_Vector load(int fd)
+	{
+		typedef typename _Vector::value_type value_type;
+		record_header header;
+		if(!detail::read_header<value_type>(fd, header))
+			throw std::runtime_error("end of file instead of a serialized vector record");
+		if(header.count > header.capacity || header.capacity > std::numeric_limits<typename _Vector::size_type>::max())
+			throw std::length_error("capacity of record too large for the vector");
+
+		_Vector v(static_cast<typename _Vector::size_type>(header.capacity));
+		detail::read_payload(fd, header, v, detail::encoding_of<value_type>());
+		return v;
+	}
+
+
+	// Collects elements in a fixed_capacity_vector of batchSize elements and writes
+	// it as a record whenever it is full, on flush() and on destruction, so a
+	// stream of any length costs one writev per batch. The reader calls try_read()
+	// with a vector of at least batchSize capacity until it returns false.
+	template<
+		typename _Ty,
+		typename _Alloc = std::allocator<_Ty>
+	>
+	class stream_writer
+	{
+	public:
+		typedef _Ty value_type;
+
+		stream_writer(int fd, std::size_t batchSize)
+			: fd_(fd), batch_(batchSize)
+		{
+			assert(batchSize > 0 && "stream_writer needs room for at least one element");
+		}
+
+		stream_writer(const stream_writer&) = delete;
+		stream_writer& operator=(const stream_writer&) = delete;
+
+		// flushes the remaining elements, errors are ignored; call flush() to see them
+		~stream_writer() FCV_NOEXCEPT
+		{
+			try
+			{
+				flush();
+			}
+			catch(...)
+			{
+			}
+		}
+
+		template<
+			typename... _TyArgs
+		>
+		void emplace(_TyArgs&&... args)
+		{
+			if(batch_.size() == batch_.capacity())
+				flush();
+			batch_.emplace_back(std::forward<_TyArgs>(args)...);
+		}
+
+		void push(const value_type& value)
+		{
+			emplace(value);
+		}
+
+		void push(value_type&& value)
+		{
+			emplace(std::move(value));
+		}
+
+		// writes the buffered elements as a record, if there are any
+		void flush()
+		{
+			if(batch_.empty())
+				return;
+			fcv_serialization::write(fd_, batch_);
+			batch_.clear();
+		}
+
+		std::size_t buffered() const FCV_NOEXCEPT
+		{
+			return batch_.size();
+		}
+
+	private:
+		int fd_;
+		fixed_capacity_vector<value_type, _Alloc, std::size_t> batch_;
+	};
+}
@@ -0,0 +1,350 @@
+
+#pragma once
+
+#include "posix_io.h"
+#include "vector.h"
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Pointer stored as the distance from its own address to the target, so it stays
+// valid when the memory holding both is mapped at a different address by another
+// process. An offset of 1 encodes nullptr.
+template<
+	typename T
+>
+class offset_ptr
+{
+public:
+	typedef T element_type;
+
+	offset_ptr() FCV_NOEXCEPT
+		: offset_(1)
+	{
+	}
+
+	offset_ptr(std::nullptr_t) FCV_NOEXCEPT
+		: offset_(1)
+	{
+	}
+
+	offset_ptr(T* p) FCV_NOEXCEPT
+	{
+		_set(p);
+	}
+
+	// the offset is relative to this object, so copies recompute it
+	offset_ptr(const offset_ptr& other) FCV_NOEXCEPT
+	{
+		_set(other.get());
+	}
+
+	offset_ptr& operator=(const offset_ptr& other) FCV_NOEXCEPT
+	{
+		_set(other.get());
+		return *this;
+	}
+
+	offset_ptr& operator=(T* p) FCV_NOEXCEPT
+	{
+		_set(p);
+		return *this;
+	}
+
+	T* get() const FCV_NOEXCEPT
+	{
+		return offset_ == 1 ? nullptr
+			: reinterpret_cast<T*>(reinterpret_cast<std::intptr_t>(this) + offset_);
+	}
+
+	T& operator*() const { return *get(); }
+	T* operator->() const FCV_NOEXCEPT { return get(); }
+	T& operator[](std::ptrdiff_t index) const { return get()[index]; }
+	explicit operator bool() const FCV_NOEXCEPT { return offset_ != 1; }
+
+	bool operator==(const offset_ptr& other) const FCV_NOEXCEPT { return get() == other.get(); }
+	bool operator!=(const offset_ptr& other) const FCV_NOEXCEPT { return get() != other.get(); }
+
+private:
+	void _set(T* p) FCV_NOEXCEPT
+	{
+		offset_ = p ? reinterpret_cast<std::intptr_t>(p) - reinterpret_cast<std::intptr_t>(this) : 1;
+	}
+
+	std::intptr_t offset_;
+};
+
+
+// POSIX shared memory object (shm_open) mapped read-write into this process.
+// Every process maps it at an address of the kernel's choosing. The object
+// lives until remove() is called, even after all mappings are gone.
+class shared_memory_segment
+{
+public:
+	// creates a new segment of size bytes, fails if name already exists
+	shared_memory_segment(const std::string& name, std::size_t size)
+		: fd_(-1), mapping_(nullptr), size_(size), name_(name)
+	{
+		fd_ = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+		if(fd_ < 0)
+			fcv_detail::throw_errno("cannot create shared memory segment " + name);
+		if(::ftruncate(fd_, static_cast<off_t>(size)) != 0)
+		{
+			const int error = errno;
+			_close();
+			::shm_unlink(name.c_str());
+			fcv_detail::throw_errno("cannot resize shared memory segment " + name, error);
+		}
+		_map();
+	}
+
+	// maps an existing segment
+	explicit shared_memory_segment(const std::string& name)
+		: fd_(-1), mapping_(nullptr), size_(0), name_(name)
+	{
+		fd_ = ::shm_open(name.c_str(), O_RDWR, 0600);
+		if(fd_ < 0)
+			fcv_detail::throw_errno("cannot open shared memory segment " + name);
+		struct stat st;
+		if(::fstat(fd_, &st) != 0)
+		{
+			const int error = errno;
+			_close();
+			fcv_detail::throw_errno("fstat failed", error);
+		}
+		size_ = static_cast<std::size_t>(st.st_size);
+		_map();
+	}
+
+	shared_memory_segment(const shared_memory_segment&) = delete;
+	shared_memory_segment& operator=(const shared_memory_segment&) = delete;
+
+	~shared_memory_segment() FCV_NOEXCEPT
+	{
+		_close();
+	}
+
+	void* data() const FCV_NOEXCEPT
+	{
+		return mapping_;
+	}
+
+	std::size_t size() const FCV_NOEXCEPT
+	{
+		return size_;
+	}
+
+	const std::string& name() const FCV_NOEXCEPT
+	{
+		return name_;
+	}
+
+	// removes the name of the segment, existing mappings stay valid
+	static bool remove(const std::string& name) FCV_NOEXCEPT
+	{
+		return ::shm_unlink(name.c_str()) == 0;
+	}
+
+private:
+	void _map()
+	{
+		void* p = size_ ? ::mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0) : nullptr;
+		if(p == MAP_FAILED)
+		{
+			const int error = errno;
+			_close();
+			fcv_detail::throw_errno("mmap failed", error);
+		}
+		mapping_ = p;
+	}
+
+	void _close() FCV_NOEXCEPT
+	{
+		if(mapping_)
+			::munmap(mapping_, size_);
+		if(fd_ >= 0)
+			::close(fd_);
+		mapping_ = nullptr;
+		fd_ = -1;
+	}
+
+private:
+	int fd_;
+	void* mapping_;
+	std::size_t size_;
+	std::string name_;
+};
+
+
+// Fixed capacity vector placed inside a block of shared memory together with its
+// elements. It contains no absolute addresses, the buffer is reached through an
+// offset_ptr, so every process can use it at whatever address it mapped the
+// block. One process appends, any number of processes read concurrently: an
+// element is constructed before the atomic size is advanced past it with release
+// semantics, and readers load the size with acquire semantics. Only appending is
+// safe against concurrent readers, clear() is not. Elements must be trivially
+// copyable, as anything they point to would only be valid in the process that
+// created it.
+template<
+	typename T
+>
+class shared_vector
+{
+	static_assert(std::is_trivially_copyable<T>::value, "shared_vector requires trivially copyable elements");
+
+public:
+	typedef T value_type;
+	typedef std::uint64_t size_type;
+	typedef value_type* iterator;
+	typedef const value_type* const_iterator;
+
+	shared_vector(const shared_vector&) = delete;
+	shared_vector& operator=(const shared_vector&) = delete;
+
+	// bytes of shared memory needed for a vector of the given capacity
+	static std::size_t required_bytes(size_type capacity)
+	{
+		if(capacity > (static_cast<std::size_t>(-1) - _data_offset()) / sizeof(value_type))
+			throw std::length_error("capacity of shared_vector too large");
+		return _data_offset() + static_cast<std::size_t>(capacity) * sizeof(value_type);
+	}
+
+	// constructs an empty vector at the start of memory, which must be suitably
+	// aligned (page aligned shared memory is) and hold required_bytes(capacity)
+	static shared_vector* create(void* memory, std::size_t bytes, size_type capacity)
+	{
+		assert(reinterpret_cast<std::uintptr_t>(memory) % std::alignment_of<shared_vector>::value == 0);
+		if(bytes < required_bytes(capacity))
+			throw std::length_error("shared memory too small for the capacity of shared_vector");
+		return ::new(memory) shared_vector(capacity);
+	}
+
+	static shared_vector* create(shared_memory_segment& segment, size_type capacity)
+	{
+		return create(segment.data(), segment.size(), capacity);
+	}
+
+	// the vector created at the start of memory, possibly by another process
+	static shared_vector* attach(void* memory, std::size_t bytes)
+	{
+		shared_vector* v = static_cast<shared_vector*>(memory);
+		if(bytes < _data_offset() || v->magic_ != _magic || v->elementSize_ != sizeof(value_type))
+			throw std::runtime_error("memory does not hold a shared_vector of this element type");
+		if(bytes < required_bytes(v->capacity_))
+			throw std::runtime_error("shared memory too small for the capacity of the shared_vector");
+		return v;
+	}
+
+	static shared_vector* attach(shared_memory_segment& segment)
+	{
+		return attach(segment.data(), segment.size());
+	}
+
+	// writer: appends an element, published to readers once it is fully constructed
+	template<
+		typename... _TyArgs
+	>
+	value_type& emplace_back(_TyArgs&&... args)
+	{
+		const size_type size = size_.load(std::memory_order_relaxed);
+		if(size == capacity_)
+			throw std::length_error("shared_vector out of capacity");
+
+		value_type* p = ::new(static_cast<void*>(buffer_.get() + size)) value_type(std::forward<_TyArgs>(args)...);
+		size_.store(size + 1, std::memory_order_release);
+		return *p;
+	}
+
+	void push_back(const value_type& value)
+	{
+		emplace_back(value);
+	}
+
+	// writer: empties the vector. No reader may be active: one that loaded the old
+	// size keeps reading the slots that the next emplace_back() overwrites, and
+	// can see torn elements. Synchronize with the readers before calling it.
+	void clear() FCV_NOEXCEPT
+	{
+		size_.store(0, std::memory_order_release);
+	}
+
+	size_type size() const FCV_NOEXCEPT
+	{
+		return size_.load(std::memory_order_acquire);
+	}
+
+	size_type capacity() const FCV_NOEXCEPT
+	{
+		return capacity_;
+	}
+
+	bool empty() const FCV_NOEXCEPT
+	{
+		return size() == 0;
+	}
+
+	value_type& operator[](size_type index)
+	{
+		assert(index < size());
+		return buffer_[static_cast<std::ptrdiff_t>(index)];
+	}
+
+	const value_type& operator[](size_type index) const
+	{
+		assert(index < size());
+		return buffer_[static_cast<std::ptrdiff_t>(index)];
+	}
+
+	value_type* data() FCV_NOEXCEPT
+	{
+		return buffer_.get();
+	}
+
+	const value_type* data() const FCV_NOEXCEPT
+	{
+		return buffer_.get();
+	}
+
+	// iterates over the elements published at the time of the call
+	const_iterator begin() const FCV_NOEXCEPT
+	{
+		return data();
+	}
+
+	const_iterator end() const FCV_NOEXCEPT
+	{
+		return data() + size();
+	}
+
+private:
+	enum : std::uint64_t { _magic = 0x3130564853564346ull };	// "FCVSHV01" read little endian
+
+	explicit shared_vector(size_type capacity)
+		: magic_(_magic), elementSize_(sizeof(value_type)), capacity_(capacity), size_(0)
+	{
+		assert(size_.is_lock_free() && "shared_vector requires an address-free atomic size");
+		buffer_ = reinterpret_cast<value_type*>(reinterpret_cast<char*>(this) + _data_offset());
+	}
+
+	static std::size_t _data_offset() FCV_NOEXCEPT
+	{
+		// elements start on their own cache line behind the header
+		const std::size_t alignment = std::alignment_of<value_type>::value > 64 ? std::alignment_of<value_type>::value : 64;
+		return (sizeof(shared_vector) + alignment - 1) / alignment * alignment;
+	}
+
+private:
+	std::uint64_t magic_;
+	std::uint64_t elementSize_;
+	size_type capacity_;
+	std::atomic<size_type> size_;
+	offset_ptr<value_type> buffer_;
+};
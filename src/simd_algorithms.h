@@ -0,0 +1,361 @@
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <type_traits>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define FCV_SIMD_X86 1
+#include <immintrin.h>
+#define FCV_TARGET_SSE2 __attribute__((target("sse2")))
+#define FCV_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+// Linear search and fill over contiguous containers such as fixed_capacity_vector.
+// Integral, enum and pointer elements of 1, 2, 4 or 8 bytes are compared bitwise
+// with SSE2 or AVX2 kernels, picked once at runtime depending on the CPU. Every
+// other element type (floating point included, where bitwise equality is not
+// operator==) is handed to the std algorithms.
+namespace fcv_simd
+{
+	enum class instruction_set
+	{
+		scalar,
+		sse2,
+		avx2
+	};
+
+	namespace detail
+	{
+		template<std::size_t Size> struct uint_of_size;
+		template<> struct uint_of_size<1> { typedef std::uint8_t type; };
+		template<> struct uint_of_size<2> { typedef std::uint16_t type; };
+		template<> struct uint_of_size<4> { typedef std::uint32_t type; };
+		template<> struct uint_of_size<8> { typedef std::uint64_t type; };
+
+		template<typename T>
+		struct is_simd_element : std::integral_constant<bool,
+			(std::is_integral<T>::value || std::is_enum<T>::value || std::is_pointer<T>::value)
+			&& (sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8)>
+		{
+		};
+
+		template<typename T>
+		typename uint_of_size<sizeof(T)>::type to_bits(const T& value)
+		{
+			typename uint_of_size<sizeof(T)>::type bits;
+			std::memcpy(&bits, &value, sizeof(T));
+			return bits;
+		}
+
+		template<typename U>
+		std::size_t find_scalar(const U* p, std::size_t n, U value)
+		{
+			for(std::size_t i = 0; i < n; ++i)
+				if(p[i] == value)
+					return i;
+			return n;
+		}
+
+		template<typename U>
+		std::size_t count_scalar(const U* p, std::size_t n, U value)
+		{
+			std::size_t result = 0;
+			for(std::size_t i = 0; i < n; ++i)
+				result += (p[i] == value);
+			return result;
+		}
+
+		template<typename U>
+		void fill_scalar(U* p, std::size_t n, U value)
+		{
+			for(std::size_t i = 0; i < n; ++i)
+				p[i] = value;
+		}
+
+#ifdef FCV_SIMD_X86
+		// SSE2 has no 64 bit compare, combine the two 32 bit halves instead
+		FCV_TARGET_SSE2 inline __m128i sse2_set1(std::uint8_t v) { return _mm_set1_epi8(static_cast<char>(v)); }
+		FCV_TARGET_SSE2 inline __m128i sse2_set1(std::uint16_t v) { return _mm_set1_epi16(static_cast<short>(v)); }
+		FCV_TARGET_SSE2 inline __m128i sse2_set1(std::uint32_t v) { return _mm_set1_epi32(static_cast<int>(v)); }
+		FCV_TARGET_SSE2 inline __m128i sse2_set1(std::uint64_t v) { return _mm_set1_epi64x(static_cast<long long>(v)); }
+		FCV_TARGET_SSE2 inline __m128i sse2_cmpeq(__m128i a, __m128i b, std::uint8_t) { return _mm_cmpeq_epi8(a, b); }
+		FCV_TARGET_SSE2 inline __m128i sse2_cmpeq(__m128i a, __m128i b, std::uint16_t) { return _mm_cmpeq_epi16(a, b); }
+		FCV_TARGET_SSE2 inline __m128i sse2_cmpeq(__m128i a, __m128i b, std::uint32_t) { return _mm_cmpeq_epi32(a, b); }
+		FCV_TARGET_SSE2 inline __m128i sse2_cmpeq(__m128i a, __m128i b, std::uint64_t)
+		{
+			const __m128i eq32 = _mm_cmpeq_epi32(a, b);
+			return _mm_and_si128(eq32, _mm_shuffle_epi32(eq32, _MM_SHUFFLE(2, 3, 0, 1)));
+		}
+
+		FCV_TARGET_AVX2 inline __m256i avx2_set1(std::uint8_t v) { return _mm256_set1_epi8(static_cast<char>(v)); }
+		FCV_TARGET_AVX2 inline __m256i avx2_set1(std::uint16_t v) { return _mm256_set1_epi16(static_cast<short>(v)); }
+		FCV_TARGET_AVX2 inline __m256i avx2_set1(std::uint32_t v) { return _mm256_set1_epi32(static_cast<int>(v)); }
+		FCV_TARGET_AVX2 inline __m256i avx2_set1(std::uint64_t v) { return _mm256_set1_epi64x(static_cast<long long>(v)); }
+		FCV_TARGET_AVX2 inline __m256i avx2_cmpeq(__m256i a, __m256i b, std::uint8_t) { return _mm256_cmpeq_epi8(a, b); }
+		FCV_TARGET_AVX2 inline __m256i avx2_cmpeq(__m256i a, __m256i b, std::uint16_t) { return _mm256_cmpeq_epi16(a, b); }
+		FCV_TARGET_AVX2 inline __m256i avx2_cmpeq(__m256i a, __m256i b, std::uint32_t) { return _mm256_cmpeq_epi32(a, b); }
+		FCV_TARGET_AVX2 inline __m256i avx2_cmpeq(__m256i a, __m256i b, std::uint64_t) { return _mm256_cmpeq_epi64(a, b); }
+
+		template<typename U>
+		FCV_TARGET_SSE2 std::size_t find_sse2(const U* p, std::size_t n, U value)
+		{
+			const std::size_t lanes = sizeof(__m128i) / sizeof(U);
+			const __m128i needle = sse2_set1(value);
+			std::size_t i = 0;
+			for(; i + lanes <= n; i += lanes)
+			{
+				const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+				const int mask = _mm_movemask_epi8(sse2_cmpeq(x, needle, U()));
+				if(mask)
+					return i + __builtin_ctz(static_cast<unsigned int>(mask)) / sizeof(U);
+			}
+			return i + find_scalar(p + i, n - i, value);
+		}
+
+		template<typename U>
+		FCV_TARGET_SSE2 std::size_t count_sse2(const U* p, std::size_t n, U value)
+		{
+			const std::size_t lanes = sizeof(__m128i) / sizeof(U);
+			const __m128i needle = sse2_set1(value);
+			std::size_t result = 0;
+			std::size_t i = 0;
+			for(; i + lanes <= n; i += lanes)
+			{
+				const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+				const int mask = _mm_movemask_epi8(sse2_cmpeq(x, needle, U()));
+				result += __builtin_popcount(static_cast<unsigned int>(mask));
+			}
+			return result / sizeof(U) + count_scalar(p + i, n - i, value);
+		}
+
+		template<typename U>
+		FCV_TARGET_SSE2 void fill_sse2(U* p, std::size_t n, U value)
+		{
+			const std::size_t lanes = sizeof(__m128i) / sizeof(U);
+			const __m128i x = sse2_set1(value);
+			std::size_t i = 0;
+			for(; i + lanes <= n; i += lanes)
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(p + i), x);
+			fill_scalar(p + i, n - i, value);
+		}
+
+		template<typename U>
+		FCV_TARGET_AVX2 std::size_t find_avx2(const U* p, std::size_t n, U value)
+		{
+			const std::size_t lanes = sizeof(__m256i) / sizeof(U);
+			const __m256i needle = avx2_set1(value);
+			std::size_t i = 0;
+			// four registers per iteration, the exact position is only searched on a hit
+			for(; i + 4 * lanes <= n; i += 4 * lanes)
+			{
+				const __m256i* v = reinterpret_cast<const __m256i*>(p + i);
+				const __m256i eq0 = avx2_cmpeq(_mm256_loadu_si256(v), needle, U());
+				const __m256i eq1 = avx2_cmpeq(_mm256_loadu_si256(v + 1), needle, U());
+				const __m256i eq2 = avx2_cmpeq(_mm256_loadu_si256(v + 2), needle, U());
+				const __m256i eq3 = avx2_cmpeq(_mm256_loadu_si256(v + 3), needle, U());
+				const __m256i any = _mm256_or_si256(_mm256_or_si256(eq0, eq1), _mm256_or_si256(eq2, eq3));
+				if(_mm256_movemask_epi8(any))
+					break;
+			}
+			for(; i + lanes <= n; i += lanes)
+			{
+				const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+				const int mask = _mm256_movemask_epi8(avx2_cmpeq(x, needle, U()));
+				if(mask)
+					return i + __builtin_ctz(static_cast<unsigned int>(mask)) / sizeof(U);
+			}
+			return i + find_scalar(p + i, n - i, value);
+		}
+
+		template<typename U>
+		FCV_TARGET_AVX2 std::size_t count_avx2(const U* p, std::size_t n, U value)
+		{
+			const std::size_t lanes = sizeof(__m256i) / sizeof(U);
+			const __m256i needle = avx2_set1(value);
+			std::size_t result = 0;
+			std::size_t i = 0;
+			for(; i + lanes <= n; i += lanes)
+			{
+				const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+				const int mask = _mm256_movemask_epi8(avx2_cmpeq(x, needle, U()));
+				result += __builtin_popcount(static_cast<unsigned int>(mask));
+			}
+			return result / sizeof(U) + count_scalar(p + i, n - i, value);
+		}
+
+		template<typename U>
+		FCV_TARGET_AVX2 void fill_avx2(U* p, std::size_t n, U value)
+		{
+			const std::size_t lanes = sizeof(__m256i) / sizeof(U);
+			const __m256i x = avx2_set1(value);
+			std::size_t i = 0;
+			for(; i + lanes <= n; i += lanes)
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(p + i), x);
+			fill_scalar(p + i, n - i, value);
+		}
+#endif
+
+		inline instruction_set detect_instruction_set()
+		{
+#ifdef FCV_SIMD_X86
+			__builtin_cpu_init();
+			if(__builtin_cpu_supports("avx2"))
+				return instruction_set::avx2;
+			if(__builtin_cpu_supports("sse2"))
+				return instruction_set::sse2;
+#endif
+			return instruction_set::scalar;
+		}
+
+		template<typename U>
+		struct kernels
+		{
+			std::size_t (*find)(const U*, std::size_t, U);
+			std::size_t (*count)(const U*, std::size_t, U);
+			void (*fill)(U*, std::size_t, U);
+		};
+
+		template<typename U>
+		kernels<U> kernels_for(instruction_set set)
+		{
+			kernels<U> k = { &find_scalar<U>, &count_scalar<U>, &fill_scalar<U> };
+#ifdef FCV_SIMD_X86
+			if(set == instruction_set::avx2)
+			{
+				k.find = &find_avx2<U>;
+				k.count = &count_avx2<U>;
+				k.fill = &fill_avx2<U>;
+			}
+			else if(set == instruction_set::sse2)
+			{
+				k.find = &find_sse2<U>;
+				k.count = &count_sse2<U>;
+				k.fill = &fill_sse2<U>;
+			}
+#else
+			(void)set;
+#endif
+			return k;
+		}
+
+		// kernels for the running CPU, selected on first use
+		template<typename U>
+		const kernels<U>& dispatch()
+		{
+			static const kernels<U> k = kernels_for<U>(detect_instruction_set());
+			return k;
+		}
+
+		template<typename T>
+		const T* find(const T* first, const T* last, const T& value, std::true_type)
+		{
+			typedef typename uint_of_size<sizeof(T)>::type U;
+			const std::size_t n = static_cast<std::size_t>(last - first);
+			return first + dispatch<U>().find(reinterpret_cast<const U*>(first), n, to_bits(value));
+		}
+
+		template<typename T>
+		const T* find(const T* first, const T* last, const T& value, std::false_type)
+		{
+			return std::find(first, last, value);
+		}
+
+		template<typename T>
+		std::size_t count(const T* first, const T* last, const T& value, std::true_type)
+		{
+			typedef typename uint_of_size<sizeof(T)>::type U;
+			const std::size_t n = static_cast<std::size_t>(last - first);
+			return dispatch<U>().count(reinterpret_cast<const U*>(first), n, to_bits(value));
+		}
+
+		template<typename T>
+		std::size_t count(const T* first, const T* last, const T& value, std::false_type)
+		{
+			return static_cast<std::size_t>(std::count(first, last, value));
+		}
+
+		template<typename T>
+		void fill(T* first, T* last, const T& value, std::true_type)
+		{
+			typedef typename uint_of_size<sizeof(T)>::type U;
+			const std::size_t n = static_cast<std::size_t>(last - first);
+			dispatch<U>().fill(reinterpret_cast<U*>(first), n, to_bits(value));
+		}
+
+		template<typename T>
+		void fill(T* first, T* last, const T& value, std::false_type)
+		{
+			std::fill(first, last, value);
+		}
+	}
+
+	// instruction set used by the kernels on this CPU
+	inline instruction_set active_instruction_set()
+	{
+		static const instruction_set set = detail::detect_instruction_set();
+		return set;
+	}
+
+	template<typename T>
+	const T* find(const T* first, const T* last, const T& value)
+	{
+		return detail::find(first, last, value, detail::is_simd_element<T>());
+	}
+
+	template<typename T>
+	std::size_t count(const T* first, const T* last, const T& value)
+	{
+		return detail::count(first, last, value, detail::is_simd_element<T>());
+	}
+
+	template<typename T>
+	void fill(T* first, T* last, const T& value)
+	{
+		detail::fill(first, last, value, detail::is_simd_element<T>());
+	}
+
+	// returns an iterator to the first element equal to value or end()
+	template<typename V>
+	typename V::iterator find(V& v, const typename V::value_type& value)
+	{
+		return v.begin() + (find(v.data(), v.data() + v.size(), value) - v.data());
+	}
+
+	template<typename V>
+	typename V::const_iterator find(const V& v, const typename V::value_type& value)
+	{
+		return v.begin() + (find(v.data(), v.data() + v.size(), value) - v.data());
+	}
+
+	template<typename V>
+	std::size_t count(const V& v, const typename V::value_type& value)
+	{
+		return count(v.data(), v.data() + v.size(), value);
+	}
+
+	template<typename V>
+	bool contains(const V& v, const typename V::value_type& value)
+	{
+		return find(v.data(), v.data() + v.size(), value) != v.data() + v.size();
+	}
+
+	// returns the index of the first element equal to value or -1
+	template<typename V>
+	std::ptrdiff_t index_of(const V& v, const typename V::value_type& value)
+	{
+		const auto p = find(v.data(), v.data() + v.size(), value);
+		return p == v.data() + v.size() ? -1 : p - v.data();
+	}
+
+	// assigns value to all elements of v
+	template<typename V>
+	void fill(V& v, const typename V::value_type& value)
+	{
+		fill(v.data(), v.data() + v.size(), value);
+	}
+}
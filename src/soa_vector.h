@@ -0,0 +1,463 @@
+
+#pragma once
+
+#include "vector.h"
+#include <algorithm>
+#include <cstdint>
+#include <new>
+#include <stdexcept>
+#include <tuple>
+
+namespace fcv_detail
+{
+	// C++11 stand-in for std::index_sequence
+	template<std::size_t... _Is>
+	struct index_sequence
+	{
+	};
+
+	template<std::size_t _N, std::size_t... _Is>
+	struct make_index_sequence_impl : make_index_sequence_impl<_N - 1, _N - 1, _Is...>
+	{
+	};
+
+	template<std::size_t... _Is>
+	struct make_index_sequence_impl<0, _Is...>
+	{
+		typedef index_sequence<_Is...> type;
+	};
+
+	template<std::size_t _N>
+	using make_index_sequence = typename make_index_sequence_impl<_N>::type;
+}
+
+// contiguous view of one column of a fixed_capacity_soa_vector
+template<
+	typename _Ty
+>
+class soa_span
+{
+public:
+	typedef _Ty value_type;
+	typedef _Ty* iterator;
+	typedef std::size_t size_type;
+
+	soa_span(_Ty* data, size_type size) FCV_NOEXCEPT
+		: data_(data), size_(size)
+	{
+	}
+
+	_Ty* data() const FCV_NOEXCEPT { return data_; }
+	size_type size() const FCV_NOEXCEPT { return size_; }
+	bool empty() const FCV_NOEXCEPT { return size_ == 0; }
+	iterator begin() const FCV_NOEXCEPT { return data_; }
+	iterator end() const FCV_NOEXCEPT { return data_ + size_; }
+
+	_Ty& operator[](size_type index) const
+	{
+		assert(index < size_);
+		return data_[index];
+	}
+
+private:
+	_Ty* data_;
+	size_type size_;
+};
+
+
+// Struct-of-arrays vector: row i is the tuple of the i-th elements of one
+// fixed capacity column per type in _Ts. All columns live in a single
+// allocation and each starts on its own cache line, so a pass over one field
+// only streams that column through the cache. Rows are added and removed as
+// tuples; data<I>() and column<I>() give direct access to a column and the
+// iterators zip the columns into tuples of references.
+template<
+	typename... _Ts
+>
+class fixed_capacity_soa_vector
+{
+	static_assert(sizeof...(_Ts) > 0, "fixed_capacity_soa_vector needs at least one column");
+
+	template<bool _Const>
+	class zip_iterator;
+
+public:
+	typedef std::tuple<_Ts...> value_type;
+	typedef std::tuple<_Ts&...> reference;
+	typedef std::tuple<const _Ts&...> const_reference;
+	typedef unsigned int size_type;
+	typedef zip_iterator<false> iterator;
+	typedef zip_iterator<true> const_iterator;
+
+	template<std::size_t I>
+	using column_type = typename std::tuple_element<I, value_type>::type;
+
+	static const std::size_t column_count = sizeof...(_Ts);
+
+	explicit fixed_capacity_soa_vector(size_type _capacity)
+		: storage_(nullptr), capacity_(0), size_(0)
+	{
+		_alloc(_capacity);
+	}
+
+	fixed_capacity_soa_vector(const fixed_capacity_soa_vector& other)
+		: storage_(nullptr), capacity_(0), size_(0)
+	{
+		_alloc(other.capacity());
+		try
+		{
+			for(size_type i = 0; i < other.size(); ++i)
+				_emplace_tuple(other[i], Indices());
+		}
+		catch(...)
+		{
+			clear();
+			_free();
+			throw;
+		}
+	}
+
+	fixed_capacity_soa_vector(fixed_capacity_soa_vector&& other) FCV_NOEXCEPT
+		: storage_(nullptr), capacity_(0), size_(0)
+	{
+		_swap_state(*this, other);
+	}
+
+	fixed_capacity_soa_vector& operator=(const fixed_capacity_soa_vector& other)
+	{
+		if(this != &other)
+		{
+			fixed_capacity_soa_vector copy(other);
+			_swap_state(*this, copy);
+		}
+		return *this;
+	}
+
+	fixed_capacity_soa_vector& operator=(fixed_capacity_soa_vector&& other) FCV_NOEXCEPT
+	{
+		if(this != &other)
+		{
+			clear();
+			_free();
+			_swap_state(*this, other);
+		}
+		return *this;
+	}
+
+	void swap(fixed_capacity_soa_vector& other) FCV_NOEXCEPT
+	{
+		_swap_state(*this, other);
+	}
+
+	~fixed_capacity_soa_vector() FCV_NOEXCEPT
+	{
+		clear();
+		_free();
+	}
+
+	size_type capacity() const FCV_NOEXCEPT
+	{
+		return capacity_;
+	}
+
+	size_type size() const FCV_NOEXCEPT
+	{
+		return size_;
+	}
+
+	bool empty() const FCV_NOEXCEPT
+	{
+		return size_ == 0;
+	}
+
+	bool full() const FCV_NOEXCEPT
+	{
+		return size_ == capacity_;
+	}
+
+	// appends a row, constructing the element of column I from the I-th argument
+	template<
+		typename... _Args
+	>
+	void emplace_back(_Args&&... args)
+	{
+		static_assert(sizeof...(_Args) == sizeof...(_Ts), "emplace_back needs one argument per column");
+		if(full())
+			throw std::length_error("fixed_capacity_soa_vector out of capacity");
+
+		_construct_columns<0>(std::forward<_Args>(args)...);
+		// modify size after construction to be consistent if a constructor throws
+		++size_;
+	}
+
+	void push_back(const value_type& row)
+	{
+		_emplace_tuple(row, Indices());
+	}
+
+	void push_back(value_type&& row)
+	{
+		_emplace_tuple(std::move(row), Indices());
+	}
+
+	void pop_back()
+	{
+		assert(!empty() && "pop_back() called on empty vector");
+		if(!empty())
+		{
+			--size_;
+			_destroy_rows(size_, size_ + 1, Indices());
+		}
+	}
+
+	void clear() FCV_NOEXCEPT
+	{
+		_destroy_rows(0, size_, Indices());
+		size_ = 0;
+	}
+
+	template<std::size_t I>
+	column_type<I>* data() FCV_NOEXCEPT
+	{
+		return static_cast<column_type<I>*>(columns_[I]);
+	}
+
+	template<std::size_t I>
+	const column_type<I>* data() const FCV_NOEXCEPT
+	{
+		return static_cast<const column_type<I>*>(columns_[I]);
+	}
+
+	template<std::size_t I>
+	soa_span<column_type<I>> column() FCV_NOEXCEPT
+	{
+		return soa_span<column_type<I>>(data<I>(), size_);
+	}
+
+	template<std::size_t I>
+	soa_span<const column_type<I>> column() const FCV_NOEXCEPT
+	{
+		return soa_span<const column_type<I>>(data<I>(), size_);
+	}
+
+	reference operator[](size_type index)
+	{
+		assert(index < size_);
+		return _row<reference>(this, index, Indices());
+	}
+
+	const_reference operator[](size_type index) const
+	{
+		assert(index < size_);
+		return _row<const_reference>(this, index, Indices());
+	}
+
+	reference front() { return (*this)[0]; }
+	const_reference front() const { return (*this)[0]; }
+	reference back() { return (*this)[size_ - 1]; }
+	const_reference back() const { return (*this)[size_ - 1]; }
+
+	iterator begin() FCV_NOEXCEPT { return iterator(this, 0); }
+	iterator end() FCV_NOEXCEPT { return iterator(this, size_); }
+	const_iterator begin() const FCV_NOEXCEPT { return const_iterator(this, 0); }
+	const_iterator end() const FCV_NOEXCEPT { return const_iterator(this, size_); }
+	const_iterator cbegin() const FCV_NOEXCEPT { return begin(); }
+	const_iterator cend() const FCV_NOEXCEPT { return end(); }
+
+private:
+	typedef fcv_detail::make_index_sequence<sizeof...(_Ts)> Indices;
+
+	enum { _column_alignment = 64 };
+
+	// random access iterator yielding rows as tuples of references; being a proxy
+	// iterator it works with range-for and read-only algorithms, not with std::sort
+	template<bool _Const>
+	class zip_iterator
+	{
+		typedef typename std::conditional<_Const, const fixed_capacity_soa_vector, fixed_capacity_soa_vector>::type container;
+
+	public:
+		typedef std::random_access_iterator_tag iterator_category;
+		typedef typename fixed_capacity_soa_vector::value_type value_type;
+		typedef std::ptrdiff_t difference_type;
+		typedef typename std::conditional<_Const, const_reference, fixed_capacity_soa_vector::reference>::type reference;
+		typedef void pointer;
+
+		zip_iterator()
+			: vec_(nullptr), index_(0)
+		{
+		}
+
+		zip_iterator(container* vec, size_type index)
+			: vec_(vec), index_(index)
+		{
+		}
+
+		// iterator to const_iterator conversion
+		template<bool _OtherConst, typename = typename std::enable_if<_Const && !_OtherConst>::type>
+		zip_iterator(const zip_iterator<_OtherConst>& other)
+			: vec_(other.vec_), index_(other.index_)
+		{
+		}
+
+		reference operator*() const { return _row<reference>(vec_, index_, Indices()); }
+		reference operator[](difference_type n) const { return _row<reference>(vec_, static_cast<size_type>(index_ + n), Indices()); }
+
+		zip_iterator& operator++() { ++index_; return *this; }
+		zip_iterator operator++(int) { zip_iterator tmp(*this); ++index_; return tmp; }
+		zip_iterator& operator--() { --index_; return *this; }
+		zip_iterator operator--(int) { zip_iterator tmp(*this); --index_; return tmp; }
+		zip_iterator& operator+=(difference_type n) { index_ = static_cast<size_type>(index_ + n); return *this; }
+		zip_iterator& operator-=(difference_type n) { index_ = static_cast<size_type>(index_ - n); return *this; }
+		zip_iterator operator+(difference_type n) const { return zip_iterator(vec_, static_cast<size_type>(index_ + n)); }
+		zip_iterator operator-(difference_type n) const { return zip_iterator(vec_, static_cast<size_type>(index_ - n)); }
+		difference_type operator-(const zip_iterator& other) const
+		{
+			return static_cast<difference_type>(index_) - static_cast<difference_type>(other.index_);
+		}
+
+		bool operator==(const zip_iterator& other) const { return index_ == other.index_; }
+		bool operator!=(const zip_iterator& other) const { return index_ != other.index_; }
+		bool operator<(const zip_iterator& other) const { return index_ < other.index_; }
+		bool operator>(const zip_iterator& other) const { return index_ > other.index_; }
+		bool operator<=(const zip_iterator& other) const { return index_ <= other.index_; }
+		bool operator>=(const zip_iterator& other) const { return index_ >= other.index_; }
+
+	private:
+		template<bool _OtherConst>
+		friend class zip_iterator;
+
+		container* vec_;
+		size_type index_;
+	};
+
+	static std::size_t _round_up(std::size_t n, std::size_t alignment) FCV_NOEXCEPT
+	{
+		return (n + alignment - 1) & ~(alignment - 1);
+	}
+
+	void _alloc(size_type _capacity)
+	{
+		assert(!storage_);
+		if(!_capacity)
+		{
+			for(std::size_t i = 0; i < sizeof...(_Ts); ++i)
+				columns_[i] = nullptr;
+			return;
+		}
+
+		const std::size_t sizes[] = { sizeof(_Ts)... };
+		const std::size_t alignments[] = { std::alignment_of<_Ts>::value... };
+		std::size_t offsets[sizeof...(_Ts)];
+		std::size_t bytes = 0;
+		std::size_t baseAlignment = _column_alignment;
+		for(std::size_t i = 0; i < sizeof...(_Ts); ++i)
+		{
+			const std::size_t alignment = std::max<std::size_t>(alignments[i], _column_alignment);
+			baseAlignment = std::max(baseAlignment, alignment);
+			bytes = _round_up(bytes, alignment);
+			offsets[i] = bytes;
+			if(_capacity > (static_cast<std::size_t>(-1) - bytes) / sizes[i])
+				throw std::length_error("capacity of fixed_capacity_soa_vector too large");
+			bytes += _capacity * sizes[i];
+		}
+
+		// the offsets are only aligned relative to the base, so over-allocate to place
+		// the base on the strictest column alignment, at least a cache line
+		if(bytes > static_cast<std::size_t>(-1) - baseAlignment)
+			throw std::length_error("capacity of fixed_capacity_soa_vector too large");
+		storage_ = ::operator new(bytes + baseAlignment);
+		const std::uintptr_t base = _round_up(reinterpret_cast<std::uintptr_t>(storage_), baseAlignment);
+		for(std::size_t i = 0; i < sizeof...(_Ts); ++i)
+			columns_[i] = reinterpret_cast<void*>(base + offsets[i]);
+		capacity_ = _capacity;
+	}
+
+	void _free() FCV_NOEXCEPT
+	{
+		::operator delete(storage_);
+		storage_ = nullptr;
+		capacity_ = 0;
+		for(std::size_t i = 0; i < sizeof...(_Ts); ++i)
+			columns_[i] = nullptr;
+	}
+
+	template<std::size_t I, typename _Arg, typename... _Rest>
+	void _construct_columns(_Arg&& arg, _Rest&&... rest)
+	{
+		::new(static_cast<void*>(data<I>() + size_)) column_type<I>(std::forward<_Arg>(arg));
+		try
+		{
+			_construct_columns<I + 1>(std::forward<_Rest>(rest)...);
+		}
+		catch(...)
+		{
+			_destroy(data<I>() + size_);
+			throw;
+		}
+	}
+
+	template<std::size_t I>
+	void _construct_columns()
+	{
+	}
+
+	template<typename _Tuple, std::size_t... Is>
+	void _emplace_tuple(_Tuple&& row, fcv_detail::index_sequence<Is...>)
+	{
+		emplace_back(std::get<Is>(std::forward<_Tuple>(row))...);
+	}
+
+	template<typename _Reference, typename _Container, std::size_t... Is>
+	static _Reference _row(_Container* vec, size_type index, fcv_detail::index_sequence<Is...>)
+	{
+		return _Reference(vec->template data<Is>()[index]...);
+	}
+
+	template<typename _Ty>
+	static void _destroy(_Ty* p) FCV_NOEXCEPT
+	{
+		p->~_Ty();
+	}
+
+	template<std::size_t I>
+	void _destroy_column(size_type first, size_type last) FCV_NOEXCEPT
+	{
+		if(!std::is_trivially_destructible<column_type<I>>::value)
+		{
+			for(column_type<I>* p = data<I>() + first; p != data<I>() + last; ++p)
+				_destroy(p);
+		}
+	}
+
+	template<std::size_t... Is>
+	void _destroy_rows(size_type first, size_type last, fcv_detail::index_sequence<Is...>) FCV_NOEXCEPT
+	{
+		const int expand[] = { 0, (_destroy_column<Is>(first, last), 0)... };
+		(void)expand;
+	}
+
+	static void _swap_state(fixed_capacity_soa_vector& lhs, fixed_capacity_soa_vector& rhs) FCV_NOEXCEPT
+	{
+		std::swap(lhs.storage_, rhs.storage_);
+		std::swap(lhs.capacity_, rhs.capacity_);
+		std::swap(lhs.size_, rhs.size_);
+		for(std::size_t i = 0; i < sizeof...(_Ts); ++i)
+			std::swap(lhs.columns_[i], rhs.columns_[i]);
+	}
+
+private:
+	void* storage_;
+	void* columns_[sizeof...(_Ts)];
+	size_type capacity_;
+	size_type size_;
+};
+
+template<typename... _Ts>
+const std::size_t fixed_capacity_soa_vector<_Ts...>::column_count;
+
+template<typename... _Ts>
+void swap(fixed_capacity_soa_vector<_Ts...>& lhs, fixed_capacity_soa_vector<_Ts...>& rhs) FCV_NOEXCEPT
+{
+	lhs.swap(rhs);
+}
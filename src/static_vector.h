@@ -0,0 +1,338 @@
+
+#pragma once
+
+#include "vector.h"
+#include <type_traits>
+#include <stdexcept>
+#include <new>
+
+// Sibling of fixed_capacity_vector that keeps its elements in aligned storage
+// inside the object. There is no allocator and no pointer to chase, so the whole
+// container can live on the stack or be embedded into another struct.
+template<
+	typename _Ty,
+	unsigned int _Capacity
+>
+class static_vector
+	: private fcv_detail::vector_algorithms<static_vector<_Ty, _Capacity>, _Ty, unsigned int, true>
+{
+	typedef fcv_detail::vector_algorithms<static_vector, _Ty, unsigned int, true> _algorithms;
+	friend class fcv_detail::vector_algorithms<static_vector, _Ty, unsigned int, true>;
+
+public:
+	typedef _Ty value_type;
+	typedef unsigned int size_type;
+	typedef value_type* iterator;
+	typedef const value_type* const_iterator;
+	typedef std::reverse_iterator<iterator> reverse_iterator;
+	typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+	static_vector() FCV_NOEXCEPT
+		: size_(0)
+	{
+	}
+
+	static_vector(const static_vector& other)
+		: size_(0)
+	{
+		_copy_construct(other.size(), other.data());
+	}
+
+	static_vector(static_vector&& other)
+		: size_(0)
+	{
+		if(_trivially_relocatable)
+		{
+			_relocate_from(other);
+			return;
+		}
+		_move_construct(other.size(), other.data());
+		other.clear();
+	}
+
+	static_vector(const std::initializer_list<value_type>& il)
+		: size_(0)
+	{
+		if(il.size() > _Capacity)
+			throw std::length_error("size of initializer_list exceeds capacity of static_vector");
+
+		using std::begin;
+		_copy_construct(il.size(), begin(il));
+	}
+
+	static_vector& operator=(const static_vector& other)
+	{
+		if(this != &other)
+			_assign_copy(other.size(), other.data());
+		return *this;
+	}
+
+	static_vector& operator=(static_vector&& other)
+	{
+		if(this != &other)
+		{
+			if(_trivially_relocatable)
+			{
+				clear();
+				_relocate_from(other);
+				return *this;
+			}
+
+			const size_type common = std::min(size(), other.size());
+			std::move(other.begin(), other.begin() + common, begin());
+			if(other.size() < size())
+				_destroy_tail(other.size());
+			else
+				_move_construct(other.size() - common, other.data() + common);
+			other.clear();
+		}
+		return *this;
+	}
+
+	static_vector& operator=(const std::initializer_list<value_type>& il)
+	{
+		if(il.size() > _Capacity)
+			throw std::length_error("size of initializer_list exceeds capacity of static_vector");
+
+		using std::begin;
+		_assign_copy(static_cast<size_type>(il.size()), begin(il));
+		return *this;
+	}
+
+	void swap(static_vector& other)
+	{
+		// elements live inside the objects, so there is no buffer to exchange:
+		// swap the common prefix and move the remainder over
+		if(this != &other)
+		{
+			static_vector& larger = size() < other.size() ? other : *this;
+			static_vector& smaller = size() < other.size() ? *this : other;
+
+			if(_trivially_relocatable)
+			{
+				// exchange the bytes of the live prefix of the larger one
+				unsigned char* a = reinterpret_cast<unsigned char*>(smaller.data());
+				unsigned char* b = reinterpret_cast<unsigned char*>(larger.data());
+				std::swap_ranges(a, a + larger.size() * sizeof(value_type), b);
+				std::swap(size_, other.size_);
+				return;
+			}
+
+			using std::swap;
+			for(size_type i = 0; i < smaller.size(); ++i)
+				swap(smaller.data()[i], larger.data()[i]);
+
+			const size_type common = smaller.size();
+			smaller._move_construct(larger.size() - common, larger.data() + common);
+			larger._destroy_tail(common);
+		}
+	}
+
+	~static_vector() FCV_NOEXCEPT
+	{
+		clear();
+	}
+
+	size_type capacity() const FCV_NOEXCEPT
+	{
+		return _Capacity;
+	}
+
+	size_type size() const FCV_NOEXCEPT
+	{
+		return size_;
+	}
+
+	bool empty() const FCV_NOEXCEPT
+	{
+		return size() == 0;
+	}
+
+	size_type max_size() const FCV_NOEXCEPT
+	{
+		return _Capacity;
+	}
+
+	iterator begin() FCV_NOEXCEPT
+	{
+		return data();
+	}
+
+	const_iterator begin() const FCV_NOEXCEPT
+	{
+		return cbegin();
+	}
+
+	iterator end() FCV_NOEXCEPT
+	{
+		return (data() + size());
+	}
+
+	const_iterator end() const FCV_NOEXCEPT
+	{
+		return cend();
+	}
+
+	const_iterator cbegin() const FCV_NOEXCEPT
+	{
+		return data();
+	}
+
+	const_iterator cend() const FCV_NOEXCEPT
+	{
+		return (data() + size());
+	}
+
+	reverse_iterator rbegin() FCV_NOEXCEPT
+	{
+		return reverse_iterator(end());
+	}
+
+	const_reverse_iterator rbegin() const FCV_NOEXCEPT
+	{
+		return crbegin();
+	}
+
+	reverse_iterator rend() FCV_NOEXCEPT
+	{
+		return reverse_iterator(begin());
+	}
+
+	const_reverse_iterator rend() const FCV_NOEXCEPT
+	{
+		return crend();
+	}
+
+	const_reverse_iterator crbegin() const FCV_NOEXCEPT
+	{
+		return const_reverse_iterator(end());
+	}
+
+	const_reverse_iterator crend() const FCV_NOEXCEPT
+	{
+		return const_reverse_iterator(begin());
+	}
+
+	using _algorithms::resize;
+	using _algorithms::resize_default_init;
+	using _algorithms::resize_and_overwrite;
+	using _algorithms::push_back;
+	using _algorithms::emplace_back;
+	using _algorithms::pop_back;
+	using _algorithms::insert;
+	using _algorithms::emplace;
+	using _algorithms::erase;
+	using _algorithms::assign;
+	using _algorithms::erase_unordered;
+	using _algorithms::erase_if_unordered;
+	using _algorithms::clear;
+
+	value_type& front()
+	{
+		assert(!empty() && "calling front() on empty container has undefined behavior");
+		return data()[0];
+	}
+
+	const value_type& front() const
+	{
+		assert(!empty() && "calling front() on empty container has undefined behavior");
+		return data()[0];
+	}
+
+	value_type& back()
+	{
+		assert(!empty() && "calling back() on empty container has undefined behavior");
+		return data()[size() - 1];
+	}
+
+	const value_type& back() const
+	{
+		assert(!empty() && "calling back() on empty container has undefined behavior");
+		return data()[size() - 1];
+	}
+
+	value_type& at(size_type index)
+	{
+		assert(index < size_);
+		return *(data() + index);
+	}
+
+	const value_type& at(size_type index) const
+	{
+		assert(index < size_);
+		return *(data() + index);
+	}
+
+	value_type& operator[](size_type index)
+	{
+		return at(index);
+	}
+
+	const value_type& operator[](size_type index) const
+	{
+		return at(index);
+	}
+
+	value_type* data() FCV_NOEXCEPT
+	{
+		return reinterpret_cast<value_type*>(storage_);
+	}
+
+	const value_type* data() const FCV_NOEXCEPT
+	{
+		return reinterpret_cast<const value_type*>(storage_);
+	}
+
+private:
+	using _algorithms::_req_destruction;
+	using _algorithms::_trivially_relocatable;
+	using _algorithms::_assign_copy;
+	using _algorithms::_copy_construct;
+	using _algorithms::_move_construct;
+	using _algorithms::_relocate_from;
+	using _algorithms::_destroy_tail;
+
+	typedef typename std::aligned_storage<sizeof(value_type), std::alignment_of<value_type>::value>::type _storage_type;
+
+	static const char* _name() FCV_NOEXCEPT
+	{
+		return "static_vector";
+	}
+
+	template<
+		typename... _TyArgs
+	>
+	void _emplace(value_type* dst, _TyArgs&&... args)
+	{
+		assert(dst < (data() + _Capacity));
+		::new(static_cast<void*>(dst)) value_type(std::forward<_TyArgs>(args)...);
+	}
+
+	void _default_construct(value_type* dst)
+	{
+		assert(dst < (data() + _Capacity));
+		::new(static_cast<void*>(dst)) value_type;
+	}
+
+	void _destroy(value_type* dst)
+	{
+		assert(dst);
+		if(_req_destruction)
+			dst->~value_type();
+	}
+
+private:
+	size_type size_;
+	// zero-sized arrays are ill-formed, so a capacity of 0 still reserves one slot
+	_storage_type storage_[_Capacity ? _Capacity : 1];
+};
+
+
+template<
+	typename _Ty,
+	unsigned int _Capacity
+>
+void swap(static_vector<_Ty, _Capacity>& lhs, static_vector<_Ty, _Capacity>& rhs)
+{
+	lhs.swap(rhs);
+}
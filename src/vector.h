@@ -6,6 +6,12 @@
 #include <memory>
 #include <iterator>
 #include <algorithm>
+#include <type_traits>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
 
 #ifdef _MSC_VER
 #define FCV_NOEXCEPT _NOEXCEPT
@@ -13,30 +19,843 @@
 #define FCV_NOEXCEPT noexcept
 #endif
 
+namespace fcv_detail
+{
+	template<typename _Alloc, typename _Ty, typename = void>
+	struct alloc_has_construct : std::false_type {};
+
+	template<typename _Alloc, typename _Ty>
+	struct alloc_has_construct<_Alloc, _Ty, decltype(std::declval<_Alloc&>().construct(
+		std::declval<_Ty*>(), std::declval<const _Ty&>()), void())> : std::true_type {};
+
+	template<typename _Alloc, typename _Ty, typename = void>
+	struct alloc_has_destroy : std::false_type {};
+
+	template<typename _Alloc, typename _Ty>
+	struct alloc_has_destroy<_Alloc, _Ty, decltype(std::declval<_Alloc&>().destroy(
+		std::declval<_Ty*>()), void())> : std::true_type {};
+
+	// true if constructing and destroying elements through _Alloc is indistinguishable
+	// from placement new and a plain destructor call, i.e. the container may bypass
+	// allocator_traits::construct/destroy and work on raw memory in bulk
+	template<typename _Alloc>
+	struct uses_default_construct : std::integral_constant<bool,
+		std::is_same<_Alloc, std::allocator<typename _Alloc::value_type>>::value
+		|| (!alloc_has_construct<_Alloc, typename _Alloc::value_type>::value
+			&& !alloc_has_destroy<_Alloc, typename _Alloc::value_type>::value)>
+	{
+	};
+
+	// true if elements may be copied and moved with memcpy: copy and move
+	// construction and destruction are trivial. Weaker than is_trivially_copyable,
+	// which std::pair never satisfies in libstdc++ because of its user-provided
+	// assignment operators. The containers then also copy over existing elements
+	// with memcpy instead of calling operator=, as the standard allows them to
+	// destroy and reconstruct elements instead of assigning to them. Side effects
+	// of a user-provided operator= of such a type are therefore skipped; give the
+	// type a non-trivial copy constructor if they must run.
+	template<typename _Ty>
+	struct is_bulk_copyable : std::integral_constant<bool,
+		std::is_trivially_copy_constructible<_Ty>::value
+		&& std::is_trivially_move_constructible<_Ty>::value
+		&& std::is_trivially_destructible<_Ty>::value>
+	{
+	};
+
+	template<typename _Ty>
+	bool is_zero_bits(const _Ty& value)
+	{
+		const unsigned char* p = reinterpret_cast<const unsigned char*>(&value);
+		for(std::size_t i = 0; i < sizeof(_Ty); ++i)
+			if(p[i])
+				return false;
+		return true;
+	}
+
+	// forward iterator yielding the same value count times, used to express
+	// insert(pos, count, value) as a range insertion
+	template<typename _Ty>
+	class repeat_iterator
+	{
+	public:
+		typedef std::forward_iterator_tag iterator_category;
+		typedef _Ty value_type;
+		typedef std::ptrdiff_t difference_type;
+		typedef const _Ty* pointer;
+		typedef const _Ty& reference;
+
+		repeat_iterator(const _Ty& value, difference_type index)
+			: value_(&value), index_(index)
+		{
+		}
+
+		reference operator*() const { return *value_; }
+		pointer operator->() const { return value_; }
+		repeat_iterator& operator++() { ++index_; return *this; }
+		repeat_iterator operator++(int) { repeat_iterator tmp(*this); ++index_; return tmp; }
+		bool operator==(const repeat_iterator& other) const { return index_ == other.index_; }
+		bool operator!=(const repeat_iterator& other) const { return index_ != other.index_; }
+
+	private:
+		const _Ty* value_;
+		difference_type index_;
+	};
+
+	template<typename _Iter>
+	struct enable_if_iterator : std::enable_if<!std::is_integral<_Iter>::value>
+	{
+	};
+
+	// holds the allocator of a container as an empty base where possible, so a
+	// stateless allocator does not add to the size of the container
+	template<typename _Alloc, bool = std::is_empty<_Alloc>::value && !__is_final(_Alloc)>
+	class allocator_holder : private _Alloc
+	{
+	public:
+		explicit allocator_holder(const _Alloc& allocator)
+			: _Alloc(allocator)
+		{
+		}
+
+		explicit allocator_holder(_Alloc&& allocator) FCV_NOEXCEPT
+			: _Alloc(std::move(allocator))
+		{
+		}
+
+		_Alloc& _allocator() FCV_NOEXCEPT { return *this; }
+		const _Alloc& _allocator() const FCV_NOEXCEPT { return *this; }
+	};
+
+	template<typename _Alloc>
+	class allocator_holder<_Alloc, false>
+	{
+	public:
+		explicit allocator_holder(const _Alloc& allocator)
+			: allocator_(allocator)
+		{
+		}
+
+		explicit allocator_holder(_Alloc&& allocator) FCV_NOEXCEPT
+			: allocator_(std::move(allocator))
+		{
+		}
+
+		_Alloc& _allocator() FCV_NOEXCEPT { return allocator_; }
+		const _Alloc& _allocator() const FCV_NOEXCEPT { return allocator_; }
+
+	private:
+		_Alloc allocator_;
+	};
+}
+
+// True if an object of type _Ty may be moved to another address with memcpy
+// and the source then be treated as raw memory, i.e. a move construction
+// followed by the destruction of the source has no other observable effect.
+// fixed_capacity_vector and static_vector use it to shift elements with memmove
+// in insert and erase and to relocate whole buffers without calling move
+// constructors and destructors. Defaults to trivially copyable types; user types
+// opt in by specializing it:
+//   template<> struct is_trivially_relocatable<my_type> : std::true_type {};
+template<typename _Ty>
+struct is_trivially_relocatable : std::is_trivially_copyable<_Ty>
+{
+};
+
+template<typename _Ty>
+struct is_trivially_relocatable<std::allocator<_Ty>> : std::true_type
+{
+};
+
+template<typename _Ty1, typename _Ty2>
+struct is_trivially_relocatable<std::pair<_Ty1, _Ty2>> : std::integral_constant<bool,
+	is_trivially_relocatable<_Ty1>::value && is_trivially_relocatable<_Ty2>::value>
+{
+};
+
+// the standard smart pointers only hold pointers to the object and control block
+template<typename _Ty>
+struct is_trivially_relocatable<std::unique_ptr<_Ty, std::default_delete<_Ty>>> : std::true_type
+{
+};
+
+template<typename _Ty>
+struct is_trivially_relocatable<std::shared_ptr<_Ty>> : std::true_type
+{
+};
+
+template<typename _Ty>
+struct is_trivially_relocatable<std::weak_ptr<_Ty>> : std::true_type
+{
+};
+
+// std::vector is a triple of pointers plus its allocator in libstdc++, libc++ and
+// release builds of the MSVC STL; MSVC debug iterators keep a back pointer
+#if !defined(_MSC_VER) || !defined(_ITERATOR_DEBUG_LEVEL) || _ITERATOR_DEBUG_LEVEL == 0
+template<typename _Ty, typename _Alloc>
+struct is_trivially_relocatable<std::vector<_Ty, _Alloc>> : is_trivially_relocatable<_Alloc>
+{
+};
+#endif
+
+// the short string buffer of the libstdc++ C++11 ABI string is referenced by a
+// pointer into the object itself, so only libc++ and the copy-on-write string
+// of the old libstdc++ ABI are relocatable
+#if defined(_LIBCPP_VERSION) || (defined(__GLIBCXX__) && !_GLIBCXX_USE_CXX11_ABI)
+template<typename _Ch, typename _Traits, typename _Alloc>
+struct is_trivially_relocatable<std::basic_string<_Ch, _Traits, _Alloc>> : is_trivially_relocatable<_Alloc>
+{
+};
+#endif
+
+namespace fcv_detail
+{
+	// Element algorithms shared by fixed_capacity_vector and static_vector. The
+	// containers derive from it (CRTP), make it a friend and provide the storage:
+	// data(), size(), capacity(), begin()/end(), back(), the size_ member, the
+	// element primitives _emplace(), _default_construct() and _destroy(), and
+	// _name() for the exception messages. _RawStorage is true if elements may be
+	// constructed and destroyed on raw memory in bulk, bypassing the allocator.
+	template<
+		typename _Derived,
+		typename _Ty,
+		typename _SizeType,
+		bool _RawStorage
+	>
+	class vector_algorithms
+	{
+	public:
+		typedef _Ty value_type;
+		typedef _SizeType size_type;
+		typedef value_type* iterator;
+		typedef const value_type* const_iterator;
+
+		void resize(size_type _size, const value_type& value = value_type())
+		{
+			if(_size > _self().capacity())
+				_throw_size_exceeds_capacity();
+
+			// shrink if new size is < current size
+			if(_self().size() > _size)
+				_destroy_tail(_size);
+
+			// grow if new size is > current size
+			size_type& size_ = _self().size_;
+			if(_bulk_copy && size_ < _size)
+			{
+				_bulk_fill(_self().data() + size_, _size - size_, value);
+				size_ = _size;
+			}
+			for(; size_ < _size; ++size_) // increment size after construction because constructors may throw
+				_self()._emplace(_self().data() + size_, value);
+		}
+
+		// like resize(), but new elements are default-initialized, so trivial types
+		// are left uninitialized instead of being zeroed
+		void resize_default_init(size_type _size)
+		{
+			if(_size > _self().capacity())
+				_throw_size_exceeds_capacity();
+
+			size_type& size_ = _self().size_;
+			if(size_ > _size)
+			{
+				_destroy_tail(_size);
+				return;
+			}
+			if(_trivial_default_init)
+			{
+				size_ = _size;
+				return;
+			}
+			for(; size_ < _size; ++size_)
+				_self()._default_construct(_self().data() + size_);
+		}
+
+		// resizes to _size elements like resize_default_init() and hands them to
+		// op(data(), _size), which fills them and returns how many to keep
+		template<typename _Op>
+		void resize_and_overwrite(size_type _size, _Op op)
+		{
+			const size_type oldSize = _self().size();
+			resize_default_init(_size);
+
+			size_type newSize;
+			try
+			{
+				newSize = static_cast<size_type>(op(_self().data(), _size));
+			}
+			catch(...)
+			{
+				_destroy_tail(std::min(oldSize, _size));
+				throw;
+			}
+			assert(newSize <= _size && "resize_and_overwrite() operation returned more elements than requested");
+			_destroy_tail(std::min(newSize, _size));
+		}
+
+		void push_back(const value_type& value)
+		{
+			emplace_back(value);
+		}
+
+		void push_back(value_type&& value)
+		{
+			emplace_back(std::move(value));
+		}
+
+		template<
+			typename... _TyArgs
+		>
+		value_type& emplace_back(_TyArgs&&... args)
+		{
+			size_type& size_ = _self().size_;
+			if(size_ == _self().capacity())
+				_throw_out_of_capacity();
+
+			_self()._emplace(_self().data() + size_, std::forward<_TyArgs>(args)...);
+			// modify size after construction to be consistent if the constructor throws
+			++size_;
+			return _self().back();
+		}
+
+		void pop_back()
+		{
+			assert(!_self().empty() && "pop_back() called on empty vector");
+			if(!_self().empty())
+			{
+				// destructors should not throw but in case one does, we still stay
+				// in a consistent state if we decrement size first
+				--_self().size_;
+				_self()._destroy(_self().data() + _self().size_);
+			}
+		}
+
+		iterator insert(const_iterator pos, const value_type& value)
+		{
+			return _insert_one(pos, value);
+		}
+
+		iterator insert(const_iterator pos, value_type&& value)
+		{
+			return _insert_one(pos, std::move(value));
+		}
+
+		template<
+			typename... _TyArgs
+		>
+		iterator emplace(const_iterator pos, _TyArgs&&... args)
+		{
+			if(_self().size() == _self().capacity())
+				_throw_out_of_capacity();
+
+			_check_iterator(pos, true);
+			if(pos == _self().cend())
+			{
+				emplace_back(std::forward<_TyArgs>(args)...);
+				return _self().end() - 1;
+			}
+
+			// arguments may refer to elements that are about to be shifted,
+			// so the new element is built before the gap is opened
+			value_type value(std::forward<_TyArgs>(args)...);
+			return _insert_one(pos, std::move(value));
+		}
+
+		iterator erase(const_iterator pos)
+		{
+			_check_iterator(pos, false);
+			return erase(pos, pos + 1);
+		}
+
+		iterator insert(const_iterator pos, size_type count, const value_type& value)
+		{
+			if(count > _self().capacity() - _self().size())
+				_throw_out_of_capacity();
+
+			_check_iterator(pos, true);
+			if(&value >= _self().cbegin() && &value < _self().cend())
+			{
+				// value would be moved by the shift, insert a copy instead
+				const value_type copy(value);
+				return _insert_range(pos, repeat_iterator<value_type>(copy, 0),
+					repeat_iterator<value_type>(copy, count), std::forward_iterator_tag());
+			}
+			return _insert_range(pos, repeat_iterator<value_type>(value, 0),
+				repeat_iterator<value_type>(value, count), std::forward_iterator_tag());
+		}
+
+		template<
+			typename _InputIt,
+			typename = typename enable_if_iterator<_InputIt>::type
+		>
+		iterator insert(const_iterator pos, _InputIt first, _InputIt last)
+		{
+			_check_iterator(pos, true);
+			return _insert_range(pos, first, last, typename std::iterator_traits<_InputIt>::iterator_category());
+		}
+
+		iterator insert(const_iterator pos, std::initializer_list<value_type> il)
+		{
+			return insert(pos, il.begin(), il.end());
+		}
+
+		iterator erase(const_iterator first, const_iterator last)
+		{
+			_check_iterator(first, true);
+			_check_iterator(last, true);
+			assert(first <= last && "invalid iterator range");
+
+			auto p = const_cast<iterator>(first);
+			auto q = const_cast<iterator>(last);
+			if(p == q)
+				return p;
+
+			const size_type count = static_cast<size_type>(q - p);
+			if(_trivially_relocatable)
+			{
+				// destroy the erased elements and move the tail down with a single memmove
+				for(auto i = p; i != q; ++i)
+					_self()._destroy(i);
+				std::memmove(static_cast<void*>(p), static_cast<const void*>(q), (_self().end() - q) * sizeof(value_type));
+				_self().size_ -= count;
+			}
+			else
+			{
+				std::move(q, _self().end(), p);
+				_destroy_tail(_self().size() - count);
+			}
+			return p;
+		}
+
+		template<
+			typename _InputIt,
+			typename = typename enable_if_iterator<_InputIt>::type
+		>
+		void assign(_InputIt first, _InputIt last)
+		{
+			_assign_range(first, last, typename std::iterator_traits<_InputIt>::iterator_category());
+		}
+
+		void assign(size_type count, const value_type& value)
+		{
+			if(count > _self().capacity())
+				_throw_size_exceeds_capacity();
+
+			// overwrite the live elements first, value may refer to one of them
+			std::fill_n(_self().begin(), std::min(count, _self().size()), value);
+			resize(count, value);
+		}
+
+		void assign(std::initializer_list<value_type> il)
+		{
+			assign(il.begin(), il.end());
+		}
+
+		// erases the element at pos by moving the last element into its place;
+		// constant time, but the order of the elements is not preserved
+		iterator erase_unordered(const_iterator pos)
+		{
+			_check_iterator(pos, false);
+
+			auto p = const_cast<iterator>(pos);
+			const auto last = _self().end() - 1;
+			if(_trivially_relocatable)
+			{
+				_self()._destroy(p);
+				if(p != last)
+					std::memcpy(static_cast<void*>(p), static_cast<const void*>(last), sizeof(value_type));
+				--_self().size_;
+			}
+			else
+			{
+				if(p != last)
+					*p = std::move(*last);
+				pop_back();
+			}
+			return p;
+		}
+
+		// erases all elements for which pred returns true in a single pass, filling
+		// the holes with elements from the back; returns the number of erased elements
+		template<typename _Pred>
+		size_type erase_if_unordered(_Pred pred)
+		{
+			const size_type oldSize = _self().size();
+			iterator first = _self().begin();
+			iterator last = _self().end();
+			for(;;)
+			{
+				for(; first != last && !pred(*first); )
+					++first;
+				if(first == last)
+					break;
+
+				// *first is erased, find the last element that is kept to replace it
+				do
+				{
+					--last;
+				}
+				while(first != last && pred(*last));
+				if(first == last)
+					break;
+
+				*first = std::move(*last);
+				++first;
+			}
+			_destroy_tail(static_cast<size_type>(first - _self().begin()));
+			return oldSize - _self().size();
+		}
+
+		void clear()
+		{
+			_destroy_tail(0);
+		}
+
+	protected:
+		enum { _req_destruction = !std::is_trivially_destructible<value_type>::value };
+		// copies of bulk copyable elements may be done with memcpy as long as the
+		// allocator does not need to see every single construction
+		enum { _bulk_copy = is_bulk_copyable<value_type>::value && _RawStorage };
+		// default-initialization leaves the memory untouched
+		enum { _trivial_default_init = std::is_trivially_default_constructible<value_type>::value && _RawStorage };
+		// elements may be moved around in memory with memmove, skipping the move
+		// constructor and the destructor of the source
+		enum { _trivially_relocatable = is_trivially_relocatable<value_type>::value && _RawStorage };
+
+		// replaces the elements with copies of the n elements at src
+		void _assign_copy(size_type n, const value_type* src)
+		{
+			assert(n <= _self().capacity());
+			const size_type common = std::min(n, _self().size());
+			_copy_assign(common, _self().data(), src);
+			if(n < _self().size())
+				_destroy_tail(n);
+			else
+				_copy_construct(n - common, src + common);
+		}
+
+		void _copy_assign(size_type n, value_type* dst, const value_type* src)
+		{
+			// the old elements are trivially destructible, so copying the bytes over
+			// them is the same as destroying and copy constructing them
+			if(_bulk_copy)
+			{
+				if(n)
+					std::memcpy(static_cast<void*>(dst), static_cast<const void*>(src), n * sizeof(value_type));
+				return;
+			}
+			for(; n > 0; --n)
+				*dst++ = *src++;
+		}
+
+		// appends copies of the n elements at src
+		void _copy_construct(size_type n, const value_type* src)
+		{
+			size_type& size_ = _self().size_;
+			assert(size_ + n <= _self().capacity());
+			if(_bulk_copy)
+			{
+				if(n)
+					std::memcpy(static_cast<void*>(_self().data() + size_), static_cast<const void*>(src), n * sizeof(value_type));
+				size_ += n;
+				return;
+			}
+			for(value_type* p = _self().data() + size_; n>0; --n, ++size_)
+				_self()._emplace(p++, *src++);
+		}
+
+		// appends the n elements at src, moving them
+		void _move_construct(size_type n, value_type* src)
+		{
+			size_type& size_ = _self().size_;
+			assert(size_ + n <= _self().capacity());
+			if(_bulk_copy)
+			{
+				if(n)
+					std::memcpy(static_cast<void*>(_self().data() + size_), static_cast<const void*>(src), n * sizeof(value_type));
+				size_ += n;
+				return;
+			}
+			for(value_type* p = _self().data() + size_; n>0; --n, ++size_)
+				_self()._emplace(p++, std::move(*src++));
+		}
+
+		// takes over all elements of other bitwise, other is left empty without
+		// running any destructor
+		void _relocate_from(_Derived& other) FCV_NOEXCEPT
+		{
+			assert(_trivially_relocatable && _self().empty() && other.size() <= _self().capacity());
+			if(other.size_)
+				std::memcpy(static_cast<void*>(_self().data()), static_cast<const void*>(other.data()), other.size_ * sizeof(value_type));
+			_self().size_ = other.size_;
+			other.size_ = 0;
+		}
+
+		// destroys all elements from index _size on; trivially destructible
+		// elements are dropped in one step
+		void _destroy_tail(size_type _size)
+		{
+			size_type& size_ = _self().size_;
+			assert(_size <= size_);
+			if(!_req_destruction)
+			{
+				size_ = _size;
+				return;
+			}
+			for(; size_ > _size; )
+			{
+				// decrement size first to stay consistent if a destructor throws
+				--size_;
+				_self()._destroy(_self().data() + size_);
+			}
+		}
+
+		void _check_iterator(const_iterator iter, bool include_end) const
+		{
+			assert(iter >= _self().begin() && (include_end ? (iter <= _self().end()) : (iter < _self().end()))
+				&& "iterator not valid");
+			(void)iter;
+			(void)include_end;
+		}
+
+	private:
+		_Derived& _self() FCV_NOEXCEPT
+		{
+			return static_cast<_Derived&>(*this);
+		}
+
+		const _Derived& _self() const FCV_NOEXCEPT
+		{
+			return static_cast<const _Derived&>(*this);
+		}
+
+		static void _throw_out_of_capacity()
+		{
+			throw std::length_error(std::string(_Derived::_name()) + " out of capacity");
+		}
+
+		static void _throw_size_exceeds_capacity()
+		{
+			throw std::length_error(std::string("size exceeds capacity of ") + _Derived::_name());
+		}
+
+		void _bulk_fill(value_type* dst, size_type n, const value_type& value)
+		{
+			assert(_bulk_copy);
+			if(is_zero_bits(value))
+				std::memset(static_cast<void*>(dst), 0, n * sizeof(value_type));
+			else
+				std::uninitialized_fill_n(dst, n, value);
+		}
+
+		template<typename _Value>
+		iterator _insert_one(const_iterator pos, _Value&& value)
+		{
+			if(_self().size() == _self().capacity())
+				_throw_out_of_capacity();
+
+			_check_iterator(pos, true);
+			auto p = const_cast<iterator>(pos);
+			if(p == _self().end())
+			{
+				emplace_back(std::forward<_Value>(value));
+				return p;
+			}
+
+			// value may refer to an element behind pos, which is shifted by one
+			auto src = const_cast<value_type*>(std::addressof(value));
+			if(src >= p && src < _self().end())
+				++src;
+
+			const auto last = _self().end();
+			if(_trivially_relocatable)
+			{
+				std::memmove(static_cast<void*>(p + 1), static_cast<const void*>(p), (last - p) * sizeof(value_type));
+				try
+				{
+					_self()._emplace(p, std::forward<_Value>(*src));
+				}
+				catch(...)
+				{
+					std::memmove(static_cast<void*>(p), static_cast<const void*>(p + 1), (last - p) * sizeof(value_type));
+					throw;
+				}
+				++_self().size_;
+			}
+			else
+			{
+				// move the last element into raw memory and shift the others by one
+				_self()._emplace(last, std::move(*(last - 1)));
+				++_self().size_;
+				std::move_backward(p, last - 1, last);
+				*p = std::forward<_Value>(*src);
+			}
+			return p;
+		}
+
+		template<typename _InputIt>
+		iterator _insert_range(const_iterator pos, _InputIt first, _InputIt last, std::input_iterator_tag)
+		{
+			// the length of a single pass range is unknown upfront: append it and
+			// rotate it into position once
+			const size_type index = static_cast<size_type>(pos - _self().cbegin());
+			const size_type oldSize = _self().size();
+			try
+			{
+				for(; first != last; ++first)
+					emplace_back(*first);
+			}
+			catch(...)
+			{
+				_destroy_tail(oldSize);
+				throw;
+			}
+			std::rotate(_self().begin() + index, _self().begin() + oldSize, _self().end());
+			return _self().begin() + index;
+		}
+
+		template<typename _ForwardIt>
+		iterator _insert_range(const_iterator pos, _ForwardIt first, _ForwardIt last, std::forward_iterator_tag)
+		{
+			const auto count = std::distance(first, last);
+			if(count > static_cast<decltype(count)>(_self().capacity() - _self().size()))
+				_throw_out_of_capacity();
+
+			auto p = const_cast<iterator>(pos);
+			if(!count)
+				return p;
+
+			size_type& size_ = _self().size_;
+			value_type* const data = _self().data();
+			const size_type n = static_cast<size_type>(count);
+			const size_type elemsAfter = static_cast<size_type>(_self().end() - p);
+			if(_trivially_relocatable)
+			{
+				// open the gap with a single memmove and construct into it
+				std::memmove(static_cast<void*>(p + n), static_cast<const void*>(p), elemsAfter * sizeof(value_type));
+				size_type constructed = 0;
+				try
+				{
+					for(; first != last; ++first, ++constructed)
+						_self()._emplace(p + constructed, *first);
+				}
+				catch(...)
+				{
+					for(auto i = p; i != p + constructed; ++i)
+						_self()._destroy(i);
+					std::memmove(static_cast<void*>(p), static_cast<const void*>(p + n), elemsAfter * sizeof(value_type));
+					throw;
+				}
+				size_ += n;
+			}
+			else if(elemsAfter > n)
+			{
+				// move the last n elements into raw memory, shift the rest backwards
+				// and assign the new values over the moved-from elements
+				const auto oldEnd = _self().end();
+				for(auto i = oldEnd - n; i != oldEnd; ++i, ++size_)
+					_self()._emplace(data + size_, std::move(*i));
+				std::move_backward(p, oldEnd - n, oldEnd);
+				std::copy(first, last, p);
+			}
+			else
+			{
+				// the new values reach into raw memory: construct their tail there,
+				// move all elements behind pos after them and assign the rest
+				const auto oldEnd = _self().end();
+				auto mid = first;
+				std::advance(mid, elemsAfter);
+				for(auto i = mid; i != last; ++i, ++size_)
+					_self()._emplace(data + size_, *i);
+				for(auto i = p; i != oldEnd; ++i, ++size_)
+					_self()._emplace(data + size_, std::move(*i));
+				std::copy(first, mid, p);
+			}
+			return p;
+		}
+
+		template<typename _InputIt>
+		void _assign_range(_InputIt first, _InputIt last, std::input_iterator_tag)
+		{
+			clear();
+			for(; first != last; ++first)
+				emplace_back(*first);
+		}
+
+		template<typename _ForwardIt>
+		void _assign_range(_ForwardIt first, _ForwardIt last, std::forward_iterator_tag)
+		{
+			const auto count = std::distance(first, last);
+			if(count > static_cast<decltype(count)>(_self().capacity()))
+				_throw_size_exceeds_capacity();
+
+			const size_type n = static_cast<size_type>(count);
+			if(n <= _self().size())
+			{
+				std::copy(first, last, _self().begin());
+				_destroy_tail(n);
+				return;
+			}
+
+			size_type& size_ = _self().size_;
+			auto mid = first;
+			std::advance(mid, size_);
+			std::copy(first, mid, _self().begin());
+			if(_bulk_copy)
+			{
+				std::uninitialized_copy(mid, last, _self().end());
+				size_ = n;
+				return;
+			}
+			for(; mid != last; ++mid, ++size_)
+				_self()._emplace(_self().data() + size_, *mid);
+		}
+	};
+}
+
+
+// _SizeType is the unsigned type used for size and capacity. Together with a
+// stateless allocator, which takes no space, the object is a pointer and two
+// _SizeType values: 16 bytes for up to 32 bit sizes on 64 bit platforms.
 template<
 	typename _Ty,
-	typename _Alloc = std::allocator<_Ty>
+	typename _Alloc = std::allocator<_Ty>,
+	typename _SizeType = unsigned int
 >
 class fixed_capacity_vector
+	: private fcv_detail::allocator_holder<_Alloc>
+	, private fcv_detail::vector_algorithms<fixed_capacity_vector<_Ty, _Alloc, _SizeType>, _Ty, _SizeType,
+		fcv_detail::uses_default_construct<_Alloc>::value>
 {
+	static_assert(std::is_integral<_SizeType>::value && std::is_unsigned<_SizeType>::value
+		&& !std::is_same<_SizeType, bool>::value, "size type of fixed_capacity_vector must be an unsigned integer");
+
+	typedef fcv_detail::allocator_holder<_Alloc> _allocator_holder;
+	using _allocator_holder::_allocator;
+
+	typedef fcv_detail::vector_algorithms<fixed_capacity_vector, _Ty, _SizeType,
+		fcv_detail::uses_default_construct<_Alloc>::value> _algorithms;
+	friend class fcv_detail::vector_algorithms<fixed_capacity_vector, _Ty, _SizeType,
+		fcv_detail::uses_default_construct<_Alloc>::value>;
+
 public:
 	typedef _Ty value_type;
 	typedef _Alloc allocator_type;
-	typedef unsigned int size_type;
+	typedef _SizeType size_type;
 	typedef value_type* iterator;
 	typedef const value_type* const_iterator;
 	typedef std::reverse_iterator<iterator> reverse_iterator;
 	typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
 
 	explicit fixed_capacity_vector(size_type _capacity, const allocator_type& allocator = allocator_type())
-		: capacity_(0), allocator_(allocator), buffer_(nullptr), size_(0)
+		: _allocator_holder(allocator), buffer_(nullptr), size_(0), capacity_(0)
 	{
 		_alloc(_capacity);
 	}
 
 	fixed_capacity_vector(const fixed_capacity_vector& other)
-		: capacity_(0), buffer_(nullptr), size_(0)
-		, allocator_(std::allocator_traits<allocator_type>::select_on_container_copy_construction(other.allocator_)) 
+		: _allocator_holder(std::allocator_traits<allocator_type>::select_on_container_copy_construction(other._allocator()))
+		, buffer_(nullptr), size_(0), capacity_(0)
 	{
 		_alloc(other.capacity());
 		_copy_construct(other.size(), other.buffer_);
@@ -44,14 +863,14 @@ public:
 
 	fixed_capacity_vector(fixed_capacity_vector&& other) FCV_NOEXCEPT
 		// [allocator.requirements] requires allocator move not to throw
-		: capacity_(0), buffer_(nullptr), size_(0), allocator_(std::move(other.allocator_))
+		: _allocator_holder(std::move(other._allocator())), buffer_(nullptr), size_(0), capacity_(0)
 	{
 		_swap_state(*this, other);
 	}
 
 	fixed_capacity_vector(size_type capacity, const std::initializer_list<value_type>& il,
 		const allocator_type& allocator = allocator_type())
-		: capacity_(0), allocator_(allocator), buffer_(nullptr), size_(0)
+		: _allocator_holder(allocator), buffer_(nullptr), size_(0), capacity_(0)
 	{
 		if(il.size() > capacity)
 			throw std::length_error("size of initializer_list exceeds capacity of fixed_capacity_vector");
@@ -66,11 +885,11 @@ public:
 		if(this != &other)
 		{
 			if(std::allocator_traits<allocator_type>::propagate_on_container_copy_assignment::value
-				&& allocator_ != other.allocator_)
+				&& _allocator() != other._allocator())
 			{
 				clear();
 				_free();
-				allocator_ = other.allocator_;
+				_allocator() = other._allocator();
 				_alloc(other.capacity());
 			}
 			else if(capacity_ != other.capacity())
@@ -80,16 +899,7 @@ public:
 				_alloc(other.capacity());
 			}
 
-			if(size() >= other.size())
-			{
-				resize(other.size());
-				_copy_assign(other.size(), buffer_, other.buffer_);
-			}
-			else
-			{
-				_copy_assign(size(), buffer_, other.buffer_);
-				_copy_construct(other.size() - size(), other.buffer_ + size());
-			}
+			_assign_copy(other.size(), other.buffer_);
 		}
 		return *this;
 	}
@@ -98,13 +908,33 @@ public:
 	{
 		if(this != &other)
 		{
+			if(!std::allocator_traits<allocator_type>::propagate_on_container_move_assignment::value
+				&& _allocator() != other._allocator())
+			{
+				// the buffer of other cannot be freed by our allocator, so move the elements
+				clear();
+				if(capacity_ != other.capacity())
+				{
+					_free();
+					_alloc(other.capacity());
+				}
+				if(_trivially_relocatable)
+				{
+					_relocate_from(other);
+					return *this;
+				}
+				_move_construct(other.size(), other.buffer_);
+				other.clear();
+				return *this;
+			}
+
 			clear();
 			_free();
 
 			if(std::allocator_traits<allocator_type>::propagate_on_container_move_assignment::value
-				&& allocator_ != other.allocator_)
+				&& _allocator() != other._allocator())
 			{
-				allocator_ = std::move(other.allocator_);
+				_allocator() = std::move(other._allocator());
 			}
 
 			assert(!size_ && !capacity_ && !buffer_);
@@ -119,16 +949,7 @@ public:
 			throw std::length_error("size of initializer_list exceeds capacity of fixed_capacity_vector");
 
 		using std::begin;
-		if(il.size() <= size())
-		{
-			resize(il.size());
-			_copy_assign(il.size(), buffer_, begin(il));
-		}
-		else
-		{
-			_copy_assign(size(), buffer_, begin(il));
-			_copy_construct(il.size() - size(), begin(il) + size());
-		}
+		_assign_copy(static_cast<size_type>(il.size()), begin(il));
 		return *this;
 	}
 
@@ -139,7 +960,7 @@ public:
 		{
 			using std::swap;
 			if(std::allocator_traits<allocator_type>::propagate_on_container_swap::value)
-				swap(allocator_, other.allocator_);
+				swap(_allocator(), other._allocator());
 			_swap_state(*this, other);
 		}
 	}
@@ -150,6 +971,11 @@ public:
 		_free();
 	}
 
+	allocator_type get_allocator() const
+	{
+		return _allocator();
+	}
+
 	size_type capacity() const FCV_NOEXCEPT 
 	{
 		return capacity_;
@@ -167,7 +993,9 @@ public:
 
 	size_type max_size() const FCV_NOEXCEPT
 	{
-		return std::allocator_traits<allocator_type>::max_size(allocator_);
+		const auto allocatorMax = std::allocator_traits<allocator_type>::max_size(_allocator());
+		const auto sizeMax = std::numeric_limits<size_type>::max();
+		return allocatorMax < sizeMax ? static_cast<size_type>(allocatorMax) : sizeMax;
 	}
 		
 	iterator begin() FCV_NOEXCEPT
@@ -230,94 +1058,19 @@ public:
 		return _make_reverse_iter(begin());
 	}
 
-	void resize(size_type _size, const value_type& value = value_type())
-	{
-		if(_size > capacity_)
-			throw std::length_error("size exceeds capacity of fixed_capacity_vector");
-		
-		// shrink if new size is < current size
-		for(; size() > _size; )
-			pop_back();
-
-		// grow if new size is > current size
-		for(; size_ < _size; ++size_) // increment size after construction because constructors may throw
-			_emplace(buffer_ + size_, value);
-	}
-		
-	void push_back(const value_type& value)
-	{
-		if(size_ == capacity_)
-			throw std::length_error("fixed_capacity_vector out of capacity");
-
-		_emplace(buffer_ + size_, value);
-		// modify size after copy to be consistent if copy-constructor throws
-		++size_;
-	}
-
-	void push_back(value_type&& value)
-	{
-		if(size_ == capacity_)
-			throw std::length_error("fixed_capacity_vector out of capacity");
-
-		_emplace(buffer_ + size_, std::move(value));
-		// modify size after move to be consistent if move-constructor throws
-		++size_;
-	}
-
-	void pop_back()
-	{
-		assert(!empty() && "pop_back() called on empty vector");
-		if(!empty())
-		{
-			// destructors should not throw but in case one does, we still stay
-			// in a consistent state if we decrement size first
- 			--size_;
- 			_destroy(buffer_ + size_);
-		}
-	}
-
-	iterator insert(const_iterator pos, const value_type& value)
-	{
-		if(size() == capacity())
-			throw std::length_error("fixed_capacity_vector out of capacity");
-
-		_check_iterator(pos, true);
-		push_back(value);
-
-		auto p = const_cast<iterator>(pos);
-		std::rotate(rbegin(), rbegin() + 1, _make_reverse_iter(p));
-		return p;
-	}
-
-	iterator insert(const_iterator pos, value_type&& value)
-	{
-		if(size() == capacity())
-			throw std::length_error("fixed_capacity_vector out of capacity");
-
-		_check_iterator(pos, true);
-		push_back(std::move(value));
-
-		auto p = const_cast<iterator>(pos);
-		std::rotate(rbegin(), rbegin() + 1, _make_reverse_iter(p));
-		return p;	
-	}
-
-	iterator erase(const_iterator pos)
-	{
-		_check_iterator(pos, false);
-
-		auto p = const_cast<iterator>(pos);
-		std::rotate(p, p + 1, end());
-		pop_back();
-
-		return p;	
-	}
-
-	void clear()
-	{
-		for(; size(); )
-			pop_back();
-	}
+	using _algorithms::resize;
+	using _algorithms::resize_default_init;
+	using _algorithms::resize_and_overwrite;
+	using _algorithms::push_back;
+	using _algorithms::emplace_back;
+	using _algorithms::pop_back;
+	using _algorithms::insert;
+	using _algorithms::emplace;
+	using _algorithms::erase;
+	using _algorithms::assign;
+	using _algorithms::erase_unordered;
+	using _algorithms::erase_if_unordered;
+	using _algorithms::clear;
 
 	value_type& front()
 	{
@@ -376,12 +1129,24 @@ public:
 	}
 	
 private:
-	enum { _req_destruction = !std::is_scalar<value_type>::value };
+	using _algorithms::_req_destruction;
+	using _algorithms::_trivially_relocatable;
+	using _algorithms::_assign_copy;
+	using _algorithms::_copy_construct;
+	using _algorithms::_move_construct;
+	using _algorithms::_relocate_from;
+
+	static const char* _name() FCV_NOEXCEPT
+	{
+		return "fixed_capacity_vector";
+	}
 
 	void _alloc(size_type _capacity)
 	{
 		assert(!buffer_);
-		buffer_ = _capacity ? std::allocator_traits<allocator_type>::allocate(allocator_, _capacity) : nullptr;
+		if(_capacity > max_size())
+			throw std::length_error("capacity exceeds max_size() of fixed_capacity_vector");
+		buffer_ = _capacity ? std::allocator_traits<allocator_type>::allocate(_allocator(), _capacity) : nullptr;
 		capacity_ = _capacity;
 	}
 
@@ -390,26 +1155,12 @@ private:
 		if(capacity_)
 		{
 			assert(buffer_);
-			std::allocator_traits<allocator_type>::deallocate(allocator_, buffer_, capacity_);
+			std::allocator_traits<allocator_type>::deallocate(_allocator(), buffer_, capacity_);
 			capacity_ = 0;
 			buffer_ = nullptr;
 		}
 	}
 
-	void _copy_assign(size_type n, value_type* dst, const value_type* src)
-	{
-		for(; n > 0; --n)
-			*dst++ = *src++;
-	}
-
-	void _copy_construct(size_type n, const value_type* src)
-	{
-		assert(!buffer_ == !n);
-		assert(size() + n <= capacity());
-		for(value_type* p = buffer_ + size(); n>0; --n, ++size_)
-			_emplace(p++, *src++);
-	}
-
 	template<
 		typename... _TyArgs
 	>
@@ -417,14 +1168,25 @@ private:
 	{
 		assert(buffer_);
 		assert(dst < (buffer_ + capacity_));
-		std::allocator_traits<allocator_type>::construct(allocator_, dst, std::forward<_TyArgs>(args)...);
+		std::allocator_traits<allocator_type>::construct(_allocator(), dst, std::forward<_TyArgs>(args)...);
+	}
+
+	void _default_construct(value_type* dst)
+	{
+		assert(buffer_);
+		assert(dst < (buffer_ + capacity_));
+		// allocator_traits can only value-initialize, use it only if the allocator has a say
+		if(fcv_detail::uses_default_construct<allocator_type>::value)
+			::new(static_cast<void*>(dst)) value_type;
+		else
+			std::allocator_traits<allocator_type>::construct(_allocator(), dst);
 	}
 
 	void _destroy(value_type* dst)
 	{
 		assert(dst);
 		if(_req_destruction)
-			std::allocator_traits<allocator_type>::destroy(allocator_, dst);
+			std::allocator_traits<allocator_type>::destroy(_allocator(), dst);
 	}
 
 	void _swap_state(fixed_capacity_vector& lhs, fixed_capacity_vector& rhs) FCV_NOEXCEPT
@@ -434,12 +1196,6 @@ private:
 		std::swap(lhs.buffer_, rhs.buffer_);
 	}
 
-	void _check_iterator(const_iterator iter, bool include_end) const
-	{
-		assert(iter >= begin() && (include_end ? (iter <= end()) : (iter < end()))
-			&& "iterator not valid");
-	}
-
 	template<typename _Iter>
 	std::reverse_iterator<_Iter> _make_reverse_iter(_Iter i) const FCV_NOEXCEPT
 	{
@@ -450,15 +1206,15 @@ private:
 	value_type* buffer_;
 	size_type size_;
 	size_type capacity_;
-	allocator_type allocator_;
 };
 
 
 template<
 	typename _Ty,
-	typename _Alloc
+	typename _Alloc,
+	typename _SizeType
 >
-void swap(fixed_capacity_vector<_Ty, _Alloc>& lhs, fixed_capacity_vector<_Ty, _Alloc>& rhs) FCV_NOEXCEPT
+void swap(fixed_capacity_vector<_Ty, _Alloc, _SizeType>& lhs, fixed_capacity_vector<_Ty, _Alloc, _SizeType>& rhs) FCV_NOEXCEPT
 {
 	lhs.swap(rhs);
 }
\ No newline at end of file